@@ -21,212 +21,984 @@ use \InvalidArgumentException;
  */
 abstract class AbstractValidator implements Validator {
 
+    /**
+     * Async bulk constraint callbacks mapped by rule name.
+     *
+     * @var \Titon\Validate\AsyncBulkConstraintMap
+     */
+    protected AsyncBulkConstraintMap $asyncBulkConstraints = Map {};
+
+    /**
+     * Async constraint callbacks mapped by rule name.
+     *
+     * @var \Titon\Validate\AsyncConstraintMap
+     */
+    protected AsyncConstraintMap $asyncConstraints = Map {};
+
+    /**
+     * When validation should stop after a rule fails.
+     *
+     * @var \Titon\Validate\BailMode
+     */
+    protected BailMode $bail = BailMode::NONE;
+
+    /**
+     * An empty map owned by the validator, which replaces the data on reset when pooled,
+     * since the data belongs to the caller and must not be cleared.
+     *
+     * @var \Titon\Validate\DataMap
+     */
+    protected DataMap $blank = Map {};
+
+    /**
+     * Bulk constraint callbacks mapped by rule name.
+     *
+     * @var \Titon\Validate\BulkConstraintMap
+     */
+    protected BulkConstraintMap $bulkConstraints = Map {};
+
+    /**
+     * Cache of async constraint results, which may be shared with other validators.
+     *
+     * @var \Titon\Validate\ConstraintCache
+     */
+    protected ?ConstraintCache $cache = null;
+
+    /**
+     * Conditions mapped by name, which decide whether a group of fields applies to a record.
+     *
+     * @var \Titon\Validate\ConditionMap
+     */
+    protected ConditionMap $conditions = Map {};
+
     /**
      * Constraint callbacks mapped by rule name.
      *
      * @var \Titon\Validate\ConstraintMap
      */
-    protected ConstraintMap $constraints = Map {};
+    protected ConstraintMap $constraints = Map {};
+
+    /**
+     * Whether the constraint maps are shared with a provider and must be copied before being modified.
+     *
+     * @var bool
+     */
+    protected bool $constraintsShared = false;
+
+    /**
+     * Cross-field constraints mapped by rule name.
+     *
+     * @var \Titon\Validate\CrossConstraintMap
+     */
+    protected CrossConstraintMap $crossConstraints = Map {};
+
+    /**
+     * Mapping of constraints to the types their options are parsed into at compile time.
+     *
+     * @var Map<string, Vector<\Titon\Validate\OptionType>>
+     */
+    protected Map<string, Vector<OptionType>> $optionTypes = Map {};
+
+    /**
+     * Mapping of pattern constraints to the index of the option that holds the pattern.
+     *
+     * @var Map<string, int>
+     */
+    protected Map<string, int> $patternConstraints = Map {};
+
+    /**
+     * Names of constraints that are pure, and whose results may be memoized.
+     *
+     * @var Set<string>
+     */
+    protected Set<string> $pureConstraints = Set {};
+
+    /**
+     * Scalar constraint variants mapped by rule name and field type.
+     *
+     * @var \Titon\Validate\ScalarConstraintMap
+     */
+    protected ScalarConstraintMap $scalarConstraints = Map {};
+
+    /**
+     * Typed constraint variants mapped by rule name, which receive parsed options.
+     *
+     * @var \Titon\Validate\ConstraintMap
+     */
+    protected ConstraintMap $typedConstraints = Map {};
+
+    /**
+     * Collector of timing and failure counters, if instrumentation is enabled.
+     *
+     * @var \Titon\Validate\Instrumentation
+     */
+    protected ?Instrumentation $instrumentation = null;
+
+    /**
+     * Name of the schema when reporting instrumentation counters.
+     *
+     * @var string
+     */
+    protected string $instrumentationName = '';
+
+    /**
+     * Whether the rules of a field run cheapest first when a bail mode is set.
+     *
+     * @var bool
+     */
+    protected bool $costOrdering = false;
+
+    /**
+     * Whether cost ordering must report the same rule as the definition order.
+     *
+     * @var bool
+     */
+    protected bool $costStrict = true;
+
+    /**
+     * Estimated cost of constraints, used when ordering rules by cost.
+     *
+     * @var Map<string, float>
+     */
+    protected Map<string, float> $costs = Map {};
+
+    /**
+     * Data to validate against.
+     *
+     * @var \Titon\Validate\DataMap
+     */
+    protected DataMap $data = Map {};
+
+    /**
+     * Errors gathered during validation.
+     *
+     * @var \Titon\Validate\ErrorMap
+     */
+    protected ErrorMap $errors = Map {};
+
+    /**
+     * Failed results of validations whose errors have not been merged into the error map yet, in the order they were run.
+     *
+     * @var Vector<\Titon\Validate\ValidationResult>
+     */
+    protected Vector<ValidationResult> $pending = Vector {};
+
+    /**
+     * Whether the result and error storage are reused across validations.
+     *
+     * @var bool
+     */
+    protected bool $pooled = false;
+
+    /**
+     * The result of the last validation, which can be read as error codes.
+     *
+     * @var \Titon\Validate\ValidationResult
+     */
+    protected ?ValidationResult $result = null;
+
+    /**
+     * Mapping of fields and the name of the condition they belong to.
+     *
+     * @var Map<string, string>
+     */
+    protected Map<string, string> $fieldConditions = Map {};
+
+    /**
+     * Mapping of fields and titles.
+     *
+     * @var \Titon\Validate\FieldMap
+     */
+    protected FieldMap $fields = Map {};
+
+    /**
+     * Mapping of fields and the scalar type of their values.
+     *
+     * @var Map<string, \Titon\Validate\FieldType>
+     */
+    protected Map<string, FieldType> $fieldTypes = Map {};
+
+    /**
+     * Fallback mapping of error messages.
+     *
+     * @var \Titon\Validate\MessageMap
+     */
+    protected MessageMap $messages = Map {};
+
+    /**
+     * The message catalog of the locale that errors are rendered in, falling back to the messages above.
+     * The catalog is shared, so validators of every locale share the same rules and compiled schema.
+     *
+     * @var \Titon\Validate\MessageCatalog
+     */
+    protected ?MessageCatalog $catalog = null;
+
+    /**
+     * Mapping of fields and validation rules.
+     *
+     * @var \Titon\Validate\RuleContainer
+     */
+    protected RuleContainer $rules = Map {};
+
+    /**
+     * The compiled schema, which is rebuilt whenever fields, rules, constraints or messages change.
+     *
+     * @var \Titon\Validate\CompiledSchema
+     */
+    protected ?CompiledSchema $schema = null;
+
+    /**
+     * The result that is refilled by every validation when pooled. It is kept across resets.
+     *
+     * @var \Titon\Validate\ValidationResult
+     */
+    protected ?ValidationResult $scratch = null;
+
+    /**
+     * Store the data to validate.
+     *
+     * @param \Titon\Validate\DataMap $data
+     */
+    public function __construct(DataMap $data = Map {}) {
+        $this->setData($data);
+    }
+
+    /**
+     * Copy the fields, rules, messages and errors, so that a copy can be modified without changing the original.
+     * Constraint maps that are shared with a provider stay shared, and are copied on the first modification.
+     */
+    public function __clone(): void {
+        if (!$this->constraintsShared) {
+            $this->constraintsShared = true;
+            $this->detachConstraints();
+        }
+
+        $this->asyncBulkConstraints = $this->asyncBulkConstraints->toMap();
+        $this->asyncConstraints = $this->asyncConstraints->toMap();
+        $this->blank = Map {};
+        $this->conditions = $this->conditions->toMap();
+        $this->errors = $this->errors->toMap();
+        $this->fieldConditions = $this->fieldConditions->toMap();
+        $this->fields = $this->fields->toMap();
+        $this->fieldTypes = $this->fieldTypes->toMap();
+        $this->messages = $this->messages->toMap();
+        $this->pending = $this->pending->toVector();
+        $this->rules = $this->rules->map($rules ==> $rules->toMap());
+        $this->scratch = null;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function addAsyncBulkConstraint(string $key, AsyncBulkConstraintCallback $callback): this {
+        $this->schema = null;
+        $this->asyncBulkConstraints[$key] = $callback;
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function addAsyncConstraint(string $key, AsyncConstraintCallback $callback): this {
+        $this->schema = null;
+        $this->asyncConstraints[$key] = $callback;
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function addBulkConstraint(string $key, BulkConstraintCallback $callback): this {
+        if (!$this->constraints->contains($key)) {
+            throw new MissingConstraintException(sprintf('Validation constraint %s does not exist', $key));
+        }
+
+        $this->schema = null;
+        $this->detachConstraints();
+        $this->bulkConstraints[$key] = $callback;
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \InvalidArgumentException
+     */
+    public function addCondition(string $name, ConditionCallback $predicate, Vector<string> $fields, string $parent = '', Vector<string> $keys = Vector {}): this {
+        if ($parent !== '' && !$this->conditions->contains($parent)) {
+            throw new InvalidArgumentException(sprintf('Parent condition %s does not exist', $parent));
+        }
+
+        $this->schema = null;
+        $this->conditions[$name] = shape(
+            'predicate' => $predicate,
+            'parent' => $parent,
+            'keys' => $keys
+        );
+
+        foreach ($fields as $field) {
+            $this->fieldConditions[$field] = $name;
+        }
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function addConstraint(string $key, ConstraintCallback $callback, bool $pure = false): this {
+        $this->schema = null;
+        $this->detachConstraints();
+        $this->constraints[$key] = $callback;
+
+        // A bulk variant or async version of the previous constraint no longer applies
+        $this->bulkConstraints->remove($key);
+        $this->asyncConstraints->remove($key);
+        $this->asyncBulkConstraints->remove($key);
+        $this->patternConstraints->remove($key);
+        $this->optionTypes->remove($key);
+        $this->typedConstraints->remove($key);
+        $this->scalarConstraints->remove($key);
+        $this->crossConstraints->remove($key);
+
+        if ($pure) {
+            $this->pureConstraints[] = $key;
+        } else {
+            $this->pureConstraints->remove($key);
+        }
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function addConstraintProvider(ConstraintProvider $provider): this {
+        $this->schema = null;
+
+        // Share the provider's maps until the validator needs to modify them
+        if ($this->constraints->isEmpty() && $this->costs->isEmpty() && $this->crossConstraints->isEmpty()) {
+            $this->shareConstraints($provider);
+
+            return $this;
+        }
+
+        $this->detachConstraints();
+        $this->constraints->setAll($provider->getConstraints());
+
+        if ($provider instanceof BulkConstraintProvider) {
+            $this->bulkConstraints->setAll($provider->getBulkConstraints());
+        }
+
+        if ($provider instanceof CostConstraintProvider) {
+            $this->costs->setAll($provider->getConstraintCosts());
+        }
+
+        if ($provider instanceof CrossConstraintProvider) {
+            $this->crossConstraints->setAll($provider->getCrossConstraints());
+        }
+
+        if ($provider instanceof PatternConstraintProvider) {
+            $this->patternConstraints->setAll($provider->getPatternConstraints());
+        }
+
+        if ($provider instanceof PureConstraintProvider) {
+            $this->pureConstraints->addAll($provider->getPureConstraints());
+        }
+
+        if ($provider instanceof ScalarConstraintProvider) {
+            $this->scalarConstraints->setAll($provider->getScalarConstraints());
+        }
+
+        if ($provider instanceof TypedConstraintProvider) {
+            $this->optionTypes->setAll($provider->getOptionTypes());
+            $this->typedConstraints->setAll($provider->getTypedConstraints());
+        }
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function addCrossConstraint(string $key, CrossConstraintCallback $callback, int $references = 1): this {
+        $this->schema = null;
+        $this->detachConstraints();
+        $this->crossConstraints[$key] = shape(
+            'callback' => $callback,
+            'references' => $references
+        );
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function addError(string $field, string $message): this {
+        $this->mergePendingErrors();
+        $this->errors[$field] = $message;
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function addField(string $field, string $title, Map<string, OptionList> $rules = Map {}): this {
+        $this->schema = null;
+        $this->fields[$field] = $title;
+
+        if (!$rules->isEmpty()) {
+            foreach ($rules as $rule => $options) {
+                $this->addRule($field, $rule, '', $options);
+            }
+        }
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function addMessages(MessageMap $messages): this {
+        $this->schema = null;
+        $this->messages->setAll($messages);
+
+        return $this;
+    }
+
+    /**
+     * Keep a failed result until its errors are read, so that messages are only rendered when needed.
+     * Return true if neither the result nor any earlier validation has failed.
+     *
+     * @param \Titon\Validate\ValidationResult $result
+     * @return bool
+     */
+    protected function addPending(ValidationResult $result): bool {
+        if (!$result->passed()) {
+            $this->pending[] = $result;
+        }
+
+        return ($this->pending->isEmpty() && count($this->errors) === 0);
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \InvalidArgumentException
+     */
+    public function addRule(string $field, string $rule, string $message, OptionList $options = Vector{}): this {
+        if (!$this->fields->contains($field)) {
+            throw new InvalidArgumentException(sprintf('Field %s does not exist', $field));
+        }
+
+        if ($this->messages->contains($rule)) {
+            $message = $message ?: $this->messages[$rule];
+        } else {
+            $this->messages[$rule] = $message;
+        }
+
+        if (!$this->rules->contains($field)) {
+            $this->rules[$field] = Map {};
+        }
+
+        $this->schema = null;
+
+        $this->rules[$field][$rule] = shape(
+            'rule' => $rule,
+            'message' => $message,
+            'options' => $options
+        );
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function addScalarConstraint(string $key, FieldType $type, ConstraintCallback $callback): this {
+        if (!$this->constraints->contains($key)) {
+            throw new MissingConstraintException(sprintf('Validation constraint %s does not exist', $key));
+        }
+
+        // Copy the variants, as they may be shared with a provider
+        $variants = $this->scalarConstraints->contains($key) ? $this->scalarConstraints[$key]->toMap() : Map {};
+        $variants[$type] = $callback;
+
+        $this->schema = null;
+        $this->detachConstraints();
+        $this->scalarConstraints[$key] = $variants;
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function addTypedConstraint(string $key, Vector<OptionType> $types, ?ConstraintCallback $callback = null): this {
+        if (!$this->constraints->contains($key)) {
+            throw new MissingConstraintException(sprintf('Validation constraint %s does not exist', $key));
+        }
+
+        $this->schema = null;
+        $this->detachConstraints();
+        $this->optionTypes[$key] = $types;
+
+        if ($callback !== null) {
+            $this->typedConstraints[$key] = $callback;
+        } else {
+            $this->typedConstraints->remove($key);
+        }
+
+        return $this;
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function compile(): CompiledSchema {
+        if ($this->schema === null) {
+            $instrumentation = $this->instrumentation;
+            $start = microtime(true);
+            $schema = CompiledSchema::fromValidator($this)
+                ->withBailMode($this->bail)
+                ->withCache($this->cache)
+                ->withCostOrdering($this->costOrdering, $this->costStrict);
+
+            if ($instrumentation !== null) {
+                $name = $this->instrumentationName ?: static::class;
+                $schema = $schema->withInstrumentation($instrumentation, $name);
+
+                $instrumentation->recordBuild($name, microtime(true) - $start);
+            }
+
+            $this->schema = $schema;
+        }
+
+        return $this->schema;
+    }
+
+    /**
+     * Copy the constraint maps if they're shared, so that modifications do not leak into other validators.
+     */
+    protected function detachConstraints(): void {
+        if ($this->constraintsShared) {
+            $this->constraints = $this->constraints->toMap();
+            $this->bulkConstraints = $this->bulkConstraints->toMap();
+            $this->costs = $this->costs->toMap();
+            $this->crossConstraints = $this->crossConstraints->toMap();
+            $this->optionTypes = $this->optionTypes->toMap();
+            $this->patternConstraints = $this->patternConstraints->toMap();
+            $this->pureConstraints = $this->pureConstraints->toSet();
+            $this->scalarConstraints = $this->scalarConstraints->toMap();
+            $this->typedConstraints = $this->typedConstraints->toMap();
+            $this->constraintsShared = false;
+        }
+    }
+
+    /**
+     * Format an error message by inserting tokens for the current field, rule, and rule options.
+     *
+     * @param string $field
+     * @param \Titon\Validate\Rule $rule
+     * @return string
+     * @throws \Titon\Validate\Exception\MissingMessageException
+     */
+    public function formatMessage(string $field, Rule $rule): string {
+        $message = $rule['message'] ?: $this->getMessages()->get($rule['rule']);
+
+        if (!$message) {
+            throw new MissingMessageException(sprintf('Error message for rule %s does not exist', $rule['rule']));
+        }
+
+        $tokens = Map {
+            'field' => $field,
+            'title' => $this->getFields()->get($field)
+        };
+
+        foreach ($rule['options'] as $i => $option) {
+            $tokens[(string) $i] = ($option instanceof Indexish) ? implode(', ', $option) : $option;
+        }
+
+        return Str::insert($message, $tokens);
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public async function genValidate(DataMap $data = Map {}): Awaitable<bool> {
+        if ($data) {
+            $this->setData($data);
+        } else if (!$this->data) {
+            return false;
+        }
+
+        $this->result = (await $this->compile()->genValidate($this->getData()))->setCatalog($this->catalog);
+
+        return $this->addPending($this->result);
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function genValidateBatch(Traversable<DataMap> $records): Awaitable<BatchResult> {
+        return $this->compile()->genValidateBatch($records);
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getAsyncBulkConstraints(): AsyncBulkConstraintMap {
+        return $this->asyncBulkConstraints;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getAsyncConstraints(): AsyncConstraintMap {
+        return $this->asyncConstraints;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getBailMode(): BailMode {
+        return $this->bail;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getBulkConstraints(): BulkConstraintMap {
+        return $this->bulkConstraints;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getConditions(): ConditionMap {
+        return $this->conditions;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getConstraintCache(): ?ConstraintCache {
+        return $this->cache;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getConstraintCosts(): Map<string, float> {
+        return $this->costs;
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * The map may be shared with a constraint provider, so it should be treated as read-only.
+     */
+    public function getConstraints(): ConstraintMap {
+        return $this->constraints;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getCrossConstraints(): CrossConstraintMap {
+        return $this->crossConstraints;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getData(): DataMap {
+        return $this->data;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getErrors(): ErrorMap {
+        $this->mergePendingErrors();
+
+        return $this->errors;
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getFieldConditions(): Map<string, string> {
+        return $this->fieldConditions;
+    }
 
     /**
-     * Data to validate against.
-     *
-     * @var \Titon\Validate\DataMap
+     * {@inheritdoc}
      */
-    protected DataMap $data = Map {};
+    public function getFields(): FieldMap {
+        return $this->fields;
+    }
 
     /**
-     * Errors gathered during validation.
-     *
-     * @var \Titon\Validate\ErrorMap
+     * {@inheritdoc}
      */
-    protected ErrorMap $errors = Map {};
+    public function getFieldTypes(): Map<string, FieldType> {
+        return $this->fieldTypes;
+    }
 
     /**
-     * Mapping of fields and titles.
-     *
-     * @var \Titon\Validate\FieldMap
+     * {@inheritdoc}
      */
-    protected FieldMap $fields = Map {};
+    public function getInstrumentation(): ?Instrumentation {
+        return $this->instrumentation;
+    }
 
     /**
-     * Fallback mapping of error messages.
-     *
-     * @var \Titon\Validate\MessageMap
+     * {@inheritdoc}
      */
-    protected MessageMap $messages = Map {};
+    public function getMessageCatalog(): ?MessageCatalog {
+        return $this->catalog;
+    }
 
     /**
-     * Mapping of fields and validation rules.
-     *
-     * @var \Titon\Validate\RuleContainer
+     * {@inheritdoc}
      */
-    protected RuleContainer $rules = Map {};
+    public function getMessages(): MessageMap {
+        return $this->messages;
+    }
 
     /**
-     * Store the data to validate.
-     *
-     * @param \Titon\Validate\DataMap $data
+     * {@inheritdoc}
      */
-    public function __construct(DataMap $data = Map {}) {
-        $this->setData($data);
+    public function getOptionTypes(): Map<string, Vector<OptionType>> {
+        return $this->optionTypes;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function addConstraint(string $key, ConstraintCallback $callback): this {
-        $this->constraints[$key] = $callback;
+    public function getPatternConstraints(): Map<string, int> {
+        return $this->patternConstraints;
+    }
 
-        return $this;
+    /**
+     * {@inheritdoc}
+     */
+    public function getPureConstraints(): Set<string> {
+        return $this->pureConstraints;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function addConstraintProvider(ConstraintProvider $provider): this {
-        $this->constraints->setAll($provider->getConstraints());
+    public function getResult(): ?ValidationResult {
+        return $this->result;
+    }
 
-        return $this;
+    /**
+     * {@inheritdoc}
+     */
+    public function getRules(): RuleContainer {
+        return $this->rules;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function addError(string $field, string $message): this {
-        $this->errors[$field] = $message;
+    public function getScalarConstraints(): ScalarConstraintMap {
+        return $this->scalarConstraints;
+    }
 
-        return $this;
+    /**
+     * {@inheritdoc}
+     */
+    public function getTypedConstraints(): ConstraintMap {
+        return $this->typedConstraints;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function addField(string $field, string $title, Map<string, OptionList> $rules = Map {}): this {
-        $this->fields[$field] = $title;
+    public function isCostOrdered(): bool {
+        return $this->costOrdering;
+    }
 
-        if (!$rules->isEmpty()) {
-            foreach ($rules as $rule => $options) {
-                $this->addRule($field, $rule, '', $options);
-            }
-        }
+    /**
+     * {@inheritdoc}
+     */
+    public function isCostStrict(): bool {
+        return $this->costStrict;
+    }
 
-        return $this;
+    /**
+     * {@inheritdoc}
+     */
+    public function isPooled(): bool {
+        return $this->pooled;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function addMessages(MessageMap $messages): this {
-        $this->messages->setAll($messages);
+    public function learnCosts(Instrumentation $instrumentation): this {
+        $this->schema = null;
+        $this->detachConstraints();
+        $this->costs->setAll($instrumentation->getCosts());
 
         return $this;
     }
 
     /**
-     * {@inheritdoc}
-     *
-     * @throws \InvalidArgumentException
+     * Render the errors of the pending results and merge them into the error map.
      */
-    public function addRule(string $field, string $rule, string $message, OptionList $options = Vector{}): this {
-        if (!$this->fields->contains($field)) {
-            throw new InvalidArgumentException(sprintf('Field %s does not exist', $field));
+    protected function mergePendingErrors(): void {
+        if ($this->pending->isEmpty()) {
+            return;
         }
 
-        if ($this->messages->contains($rule)) {
-            $message = $message ?: $this->messages[$rule];
-        } else {
-            $this->messages[$rule] = $message;
+        foreach ($this->pending as $result) {
+            $this->errors->setAll($result->getErrors());
         }
 
-        if (!$this->rules->contains($field)) {
-            $this->rules[$field] = Map {};
+        $this->pending->clear();
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function reset(): this {
+        if ($this->pooled) {
+            $this->blank->clear();
+            $this->data = $this->blank;
+        } else {
+            $this->data->clear();
         }
 
-        $this->rules[$field][$rule] = shape(
-            'rule' => $rule,
-            'message' => $message,
-            'options' => $options
-        );
+        $this->errors->clear();
+        $this->pending->clear();
+        $this->result = null;
 
         return $this;
     }
 
     /**
-     * Format an error message by inserting tokens for the current field, rule, and rule options.
+     * Validate the data by refilling the scratch result, which is allocated and sized from the schema
+     * on the first validation and whenever the schema is rebuilt.
      *
-     * @param string $field
-     * @param \Titon\Validate\Rule $rule
-     * @return string
-     * @throws \Titon\Validate\Exception\MissingMessageException
+     * @param \Titon\Validate\DataMap $data
+     * @return \Titon\Validate\ValidationResult
+     * @throws \Titon\Validate\Exception\MissingConstraintException
      */
-    public function formatMessage(string $field, Rule $rule): string {
-        $message = $rule['message'] ?: $this->getMessages()->get($rule['rule']);
+    protected function revalidate(DataMap $data): ValidationResult {
+        $schema = $this->compile();
+        $scratch = $this->scratch;
 
-        if (!$message) {
-            throw new MissingMessageException(sprintf('Error message for rule %s does not exist', $rule['rule']));
+        if ($scratch === null || $scratch->getSchema() !== $schema) {
+            $this->errors->reserve($schema->getFields()->count());
+            $this->scratch = $scratch = new ValidationResult($schema, $schema->allocateBits());
         }
 
-        $tokens = Map {
-            'field' => $field,
-            'title' => $this->getFields()->get($field)
-        };
+        return $scratch->revalidate($data);
+    }
 
-        foreach ($rule['options'] as $i => $option) {
-            $tokens[(string) $i] = ($option instanceof Indexish) ? implode(', ', $option) : $option;
-        }
+    /**
+     * {@inheritdoc}
+     */
+    public function setBailMode(BailMode $mode): this {
+        $this->schema = null;
+        $this->bail = $mode;
 
-        return Str::insert($message, $tokens);
+        return $this;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function getConstraints(): ConstraintMap {
-        return $this->constraints;
+    public function setConstraintCache(?ConstraintCache $cache): this {
+        $this->schema = null;
+        $this->cache = $cache;
+
+        return $this;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function getData(): DataMap {
-        return $this->data;
+    public function setConstraintCost(string $key, float $cost): this {
+        $this->schema = null;
+        $this->detachConstraints();
+        $this->costs[$key] = $cost;
+
+        return $this;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function getErrors(): ErrorMap {
-        return $this->errors;
+    public function setCostOrdering(bool $ordering, bool $strict = true): this {
+        $this->schema = null;
+        $this->costOrdering = $ordering;
+        $this->costStrict = $strict;
+
+        return $this;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function getFields(): FieldMap {
-        return $this->fields;
+    public function setData(DataMap $data): this {
+        $this->data = $data;
+
+        return $this;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function getMessages(): MessageMap {
-        return $this->messages;
+    public function setFieldType(string $field, FieldType $type): this {
+        $this->schema = null;
+        $this->fieldTypes[$field] = $type;
+
+        return $this;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function getRules(): RuleContainer {
-        return $this->rules;
+    public function setInstrumentation(?Instrumentation $instrumentation, string $name = ''): this {
+        $this->schema = null;
+        $this->instrumentation = $instrumentation;
+        $this->instrumentationName = $name;
+
+        return $this;
     }
 
     /**
      * {@inheritdoc}
      */
-    public function reset(): this {
-        $this->data->clear();
-        $this->errors->clear();
+    public function setMessageCatalog(?MessageCatalog $catalog): this {
+        $this->catalog = $catalog;
+
+        if ($this->result !== null) {
+            $this->result->setCatalog($catalog);
+        }
 
         return $this;
     }
@@ -234,12 +1006,53 @@ abstract class AbstractValidator implements Validator {
     /**
      * {@inheritdoc}
      */
-    public function setData(DataMap $data): this {
-        $this->data = $data;
+    public function setPooled(bool $pooled): this {
+        $this->pooled = $pooled;
+        $this->scratch = null;
 
         return $this;
     }
 
+    /**
+     * Adopt the maps of the first provider without copying them, as they are shared through the constraint registry.
+     * Maps the provider does not define stay owned by the validator.
+     *
+     * @param \Titon\Validate\ConstraintProvider $provider
+     */
+    protected function shareConstraints(ConstraintProvider $provider): void {
+        $this->constraints = $provider->getConstraints();
+        $this->constraintsShared = true;
+
+        if ($provider instanceof BulkConstraintProvider) {
+            $this->bulkConstraints = $provider->getBulkConstraints();
+        }
+
+        if ($provider instanceof CostConstraintProvider) {
+            $this->costs = $provider->getConstraintCosts();
+        }
+
+        if ($provider instanceof CrossConstraintProvider) {
+            $this->crossConstraints = $provider->getCrossConstraints();
+        }
+
+        if ($provider instanceof PatternConstraintProvider) {
+            $this->patternConstraints = $provider->getPatternConstraints();
+        }
+
+        if ($provider instanceof PureConstraintProvider) {
+            $this->pureConstraints = $provider->getPureConstraints();
+        }
+
+        if ($provider instanceof ScalarConstraintProvider) {
+            $this->scalarConstraints = $provider->getScalarConstraints();
+        }
+
+        if ($provider instanceof TypedConstraintProvider) {
+            $this->optionTypes = $provider->getOptionTypes();
+            $this->typedConstraints = $provider->getTypedConstraints();
+        }
+    }
+
     /**
      * {@inheritdoc}
      *
@@ -252,49 +1065,90 @@ abstract class AbstractValidator implements Validator {
             return false;
         }
 
-        $fieldRules = $this->getRules();
-        $constraints = $this->getConstraints();
+        if ($this->pooled) {
+            // The scratch result is refilled, so its messages have to be rendered first if they were not read
+            $this->mergePendingErrors();
+            $this->result = $this->revalidate($this->getData())->setCatalog($this->catalog);
+        } else {
+            $this->result = $this->compile()->validate($this->getData())->setCatalog($this->catalog);
+        }
 
-        foreach ($this->getData() as $field => $value) {
-            if (!$fieldRules->contains($field)) {
-                continue;
-            }
+        return $this->addPending($this->result);
+    }
 
-            $rules = $fieldRules[$field];
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function validateBatch(Traversable<DataMap> $records): BatchResult {
+        return $this->compile()->validateBatch($records);
+    }
 
-            foreach ($rules as $rule => $params) {
-                if (!$constraints->contains($rule)) {
-                    throw new MissingConstraintException(sprintf('Validation constraint %s does not exist', $rule));
-                }
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function validateChanged(DataMap $delta): bool {
+        $previous = $this->result;
+        $schema = $this->compile();
 
-                $arguments = $params['options']->toArray();
+        // The data may be shared with the caller, so the changes are merged into a copy
+        $this->data = $this->data->toMap()->setAll($delta);
 
-                // Add the input to validate as the 1st argument
-                array_unshift($arguments, $value);
+        if ($previous === null || $previous->getSchema() !== $schema || $previous->rejected() || $schema->getBailMode() === BailMode::ALL) {
+            return $this->validate();
+        }
 
-                // Execute the constraint
-                if (!call_user_func_array($constraints[$rule], $arguments)) {
-                    $this->addError($field, $this->formatMessage($field, $params));
-                }
+        $this->mergePendingErrors();
+
+        $fields = $schema->getAffectedFields($delta);
+        $result = $schema->validateFields($previous, $this->data, $fields)->setCatalog($this->catalog);
+
+        // Only the errors of re-validated fields are replaced
+        foreach ($fields as $index) {
+            $field = $schema->getFieldAt($index)['field'];
+            $error = $result->getError($field);
+
+            if ($error === null) {
+                $this->errors->remove($field);
+            } else {
+                $this->errors[$field] = $error;
             }
         }
 
-        return (count($this->errors) === 0);
+        $this->result = $result;
+
+        return ($result->passed() && count($this->errors) === 0);
     }
 
     /**
-     * Create a validator instance from a set of shorthand or expanded rule sets.
+     * {@inheritdoc}
      *
-     * @param \Titon\Validate\DataMap $data
-     * @param Map<string, mixed> $fields
-     * @return $this
+     * @throws \Titon\Validate\Exception\MissingConstraintException
      */
-    public static function makeFromShorthand(DataMap $data = Map {}, Map<string, mixed> $fields = Map {}): Validator {
-        $class = new ReflectionClass(static::class);
+    public function validateColumns(Traversable<DataMap> $records): BatchResult {
+        return $this->compile()->validateColumns($records);
+    }
 
-        /** @var \Titon\Validate\Validator $obj */
-        $obj = $class->newInstanceArgs([$data]);
+    /**
+     * {@inheritdoc}
+     *
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function validateStream(Traversable<DataMap> $records): Iterator<ValidationResult> {
+        return $this->compile()->validateStream($records);
+    }
 
+    /**
+     * Add the fields and rules of a set of shorthand or expanded rule sets to a validator.
+     *
+     * @param \Titon\Validate\Validator $obj
+     * @param Map<string, mixed> $fields
+     * @return \Titon\Validate\Validator
+     */
+    public static function applyShorthand(Validator $obj, Map<string, mixed> $fields): Validator {
         foreach ($fields as $field => $options) {
             $title = $field;
 
@@ -322,6 +1176,10 @@ abstract class AbstractValidator implements Validator {
 
             $obj->addField($field, (string) $title);
 
+            if ($options->contains('type')) {
+                $obj->setFieldType($field, FieldType::assert($options['type']));
+            }
+
             // Dereference for the type checker
             $rules = $options['rules'];
 
@@ -337,6 +1195,33 @@ abstract class AbstractValidator implements Validator {
         return $obj;
     }
 
+    /**
+     * Compile a set of shorthand or expanded rule sets into an immutable schema.
+     * The schema should be built once and reused for every data set that is validated.
+     *
+     * @param Map<string, mixed> $fields
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public static function compileFromShorthand(Map<string, mixed> $fields): CompiledSchema {
+        return static::makeFromShorthand(Map {}, $fields)->compile();
+    }
+
+    /**
+     * Create a validator instance from a set of shorthand or expanded rule sets.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @param Map<string, mixed> $fields
+     * @return $this
+     */
+    public static function makeFromShorthand(DataMap $data = Map {}, Map<string, mixed> $fields = Map {}): Validator {
+        $class = new ReflectionClass(static::class);
+
+        /** @var \Titon\Validate\Validator $obj */
+        $obj = $class->newInstanceArgs([$data]);
+
+        return static::applyShorthand($obj, $fields);
+    }
+
     /**
      * Split a shorthand rule into multiple parts.
      *
@@ -0,0 +1,221 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+use \Countable;
+
+/**
+ * Collects async constraint checks during a validation pass and resolves them together.
+ * Checks are grouped by rule and options, and repeated scalar values within a group are coalesced,
+ * so that each group is resolved with a single bulk call (when available) or one call per distinct value,
+ * with all groups running concurrently.
+ *
+ * @package Titon\Validate
+ */
+class AsyncConstraintQueue implements Countable {
+
+    /**
+     * Optional cache to check before queueing and to fill once resolved.
+     *
+     * @var \Titon\Validate\ConstraintCache
+     */
+    protected ?ConstraintCache $cache;
+
+    /**
+     * Cache keys of the distinct values, mapped by group.
+     *
+     * @var Map<string, Vector<?string>>
+     */
+    protected Map<string, Vector<?string>> $keys = Map {};
+
+    /**
+     * Position of each distinct scalar value within its group, mapped by group and cache key.
+     *
+     * @var Map<string, Map<string, int>>
+     */
+    protected Map<string, Map<string, int>> $lookup = Map {};
+
+    /**
+     * Results mapped by slot. Slots resolved from the cache are set immediately.
+     *
+     * @var Vector<bool>
+     */
+    protected Vector<bool> $results = Vector {};
+
+    /**
+     * Rules mapped by group.
+     *
+     * @var Map<string, \Titon\Validate\CompiledRule>
+     */
+    protected Map<string, CompiledRule> $rules = Map {};
+
+    /**
+     * Slots waiting on a value, as a pair of slot and value position, mapped by group.
+     *
+     * @var Map<string, Vector<Pair<int, int>>>
+     */
+    protected Map<string, Vector<Pair<int, int>>> $slots = Map {};
+
+    /**
+     * Distinct values to resolve, mapped by group.
+     *
+     * @var Map<string, Vector<mixed>>
+     */
+    protected Map<string, Vector<mixed>> $values = Map {};
+
+    /**
+     * Set the optional result cache.
+     *
+     * @param \Titon\Validate\ConstraintCache $cache
+     */
+    public function __construct(?ConstraintCache $cache = null) {
+        $this->cache = $cache;
+    }
+
+    /**
+     * Queue a check of a value against an async rule and return its slot.
+     * Slots are numbered sequentially from zero in the order checks are queued.
+     *
+     * @param \Titon\Validate\CompiledRule $rule
+     * @param mixed $value
+     * @return int
+     */
+    public function add(CompiledRule $rule, mixed $value): int {
+        $slot = $this->results->count();
+        $this->results[] = true;
+
+        $cacheKey = ConstraintCache::key($rule, $value);
+
+        // Resolve from the cache without queueing
+        if ($cacheKey !== null && $this->cache !== null) {
+            $cached = $this->cache->get($cacheKey);
+
+            if ($cached !== null) {
+                $this->results[$slot] = $cached;
+
+                return $slot;
+            }
+        }
+
+        $group = $rule['key'];
+
+        if (!$this->rules->contains($group)) {
+            $this->rules[$group] = $rule;
+            $this->values[$group] = Vector {};
+            $this->keys[$group] = Vector {};
+            $this->lookup[$group] = Map {};
+            $this->slots[$group] = Vector {};
+        }
+
+        // Coalesce repeated scalar values
+        if ($cacheKey !== null && $this->lookup[$group]->contains($cacheKey)) {
+            $position = $this->lookup[$group][$cacheKey];
+
+        } else {
+            $position = $this->values[$group]->count();
+            $this->values[$group][] = $value;
+            $this->keys[$group][] = $cacheKey;
+
+            if ($cacheKey !== null) {
+                $this->lookup[$group][$cacheKey] = $position;
+            }
+        }
+
+        $this->slots[$group][] = Pair {$slot, $position};
+
+        return $slot;
+    }
+
+    /**
+     * Return the number of queued slots, including those resolved from the cache.
+     *
+     * @return int
+     */
+    public function count(): int {
+        return $this->results->count();
+    }
+
+    /**
+     * Resolve every queued group concurrently and return the results mapped by slot.
+     * The queue is emptied afterwards.
+     *
+     * @return Awaitable<Vector<bool>>
+     */
+    public async function gen(): Awaitable<Vector<bool>> {
+        $groups = Vector {};
+        $handles = Vector {};
+
+        foreach ($this->rules as $group => $rule) {
+            $groups[] = $group;
+            $handles[] = static::genGroup($rule, $this->values[$group])->getWaitHandle();
+        }
+
+        if (!$handles->isEmpty()) {
+            $resolved = await GenVectorWaitHandle::create($handles);
+
+            foreach ($groups as $i => $group) {
+                $results = $resolved[$i];
+
+                if ($this->cache !== null) {
+                    foreach ($this->keys[$group] as $position => $key) {
+                        if ($key !== null) {
+                            $this->cache->set($key, (bool) $results[$position]);
+                        }
+                    }
+                }
+
+                foreach ($this->slots[$group] as $pair) {
+                    $this->results[$pair[0]] = (bool) $results[$pair[1]];
+                }
+            }
+        }
+
+        $results = $this->results;
+
+        $this->results = Vector {};
+        $this->rules->clear();
+        $this->values->clear();
+        $this->keys->clear();
+        $this->lookup->clear();
+        $this->slots->clear();
+
+        return $results;
+    }
+
+    /**
+     * Resolve the distinct values of a group, either with a single bulk call,
+     * or with one call per value that run concurrently.
+     *
+     * @param \Titon\Validate\CompiledRule $rule
+     * @param Vector<mixed> $values
+     * @return Awaitable<Vector<bool>>
+     */
+    protected static async function genGroup(CompiledRule $rule, Vector<mixed> $values): Awaitable<Vector<bool>> {
+        $bulk = $rule['asyncBulk'];
+
+        if ($bulk !== null) {
+            return await CompiledSchema::invokeAsyncBulk($bulk, $rule['arguments'], $values);
+        }
+
+        $async = $rule['async'];
+
+        // Sync rules do not need to wait on anything
+        if ($async === null) {
+            return $values->map($value ==> CompiledSchema::invoke($rule, $value));
+        }
+
+        $handles = Vector {};
+
+        foreach ($values as $value) {
+            $handles[] = CompiledSchema::invokeAsync($async, $rule['arguments'], $value)->getWaitHandle();
+        }
+
+        return await GenVectorWaitHandle::create($handles);
+    }
+
+}
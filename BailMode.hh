@@ -0,0 +1,23 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Determines when validation stops after a rule fails.
+ *
+ *  NONE    - Run every rule on every field (default)
+ *  FIELD   - Stop validating a field after its first failing rule
+ *  ALL     - Stop all validation after the first failing rule
+ *
+ * @package Titon\Validate
+ */
+enum BailMode : int {
+    NONE = 0;
+    FIELD = 1;
+    ALL = 2;
+}
@@ -0,0 +1,206 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+use \Countable;
+use \OutOfBoundsException;
+
+/**
+ * The outcome of validating many records against a compiled schema.
+ * Failures of every record are packed into a single bitset with one bit per schema rule,
+ * so no per-record maps are allocated until a record is inspected.
+ *
+ * @package Titon\Validate
+ */
+class BatchResult implements Countable {
+
+    /**
+     * Packed failure bits for all records.
+     *
+     * @var Vector<int>
+     */
+    protected Vector<int> $bits;
+
+    /**
+     * Number of records that were validated.
+     *
+     * @var int
+     */
+    protected int $count;
+
+    /**
+     * Rejection reasons mapped by record index.
+     *
+     * @var Map<int, string>
+     */
+    protected Map<int, string> $rejections;
+
+    /**
+     * The schema that produced this result.
+     *
+     * @var \Titon\Validate\CompiledSchema
+     */
+    protected CompiledSchema $schema;
+
+    /**
+     * Store the schema, the packed failure bits, and any rejections.
+     *
+     * @param \Titon\Validate\CompiledSchema $schema
+     * @param Vector<int> $bits
+     * @param int $count
+     * @param Map<int, string> $rejections
+     */
+    public function __construct(CompiledSchema $schema, Vector<int> $bits, int $count, Map<int, string> $rejections = Map {}) {
+        $this->schema = $schema;
+        $this->bits = $bits;
+        $this->count = $count;
+        $this->rejections = $rejections;
+    }
+
+    /**
+     * Return the number of records that were validated.
+     *
+     * @return int
+     */
+    public function count(): int {
+        return $this->count;
+    }
+
+    /**
+     * Return the packed failure bits for all records.
+     *
+     * @return Vector<int>
+     */
+    public function getBits(): Vector<int> {
+        return $this->bits;
+    }
+
+    /**
+     * Return the packed error codes of every failed rule for a record, without rendering any messages.
+     *
+     * @param int $record
+     * @return Vector<int>
+     */
+    public function getErrorCodes(int $record): Vector<int> {
+        return $this->getResult($record)->getErrorCodes();
+    }
+
+    /**
+     * Return the rendered errors for a record, optionally from a locale's message catalog.
+     *
+     * @param int $record
+     * @param \Titon\Validate\MessageCatalog $catalog
+     * @return \Titon\Validate\ErrorMap
+     */
+    public function getErrors(int $record, ?MessageCatalog $catalog = null): ErrorMap {
+        return $this->getResult($record)->setCatalog($catalog)->getErrors();
+    }
+
+    /**
+     * Return the indices of all records that failed validation.
+     *
+     * @return Vector<int>
+     */
+    public function getFailedRecords(): Vector<int> {
+        $failed = Vector {};
+
+        for ($i = 0; $i < $this->count; $i++) {
+            if (!$this->recordPassed($i)) {
+                $failed[] = $i;
+            }
+        }
+
+        return $failed;
+    }
+
+    /**
+     * Return the rejection reasons mapped by record index.
+     *
+     * @return Map<int, string>
+     */
+    public function getRejections(): Map<int, string> {
+        return $this->rejections;
+    }
+
+    /**
+     * Return a result view for a single record. The view shares the batch's bitset.
+     *
+     * @param int $record
+     * @return \Titon\Validate\ValidationResult
+     * @throws \OutOfBoundsException
+     */
+    public function getResult(int $record): ValidationResult {
+        if ($record < 0 || $record >= $this->count) {
+            throw new OutOfBoundsException(sprintf('Record %s does not exist', $record));
+        }
+
+        return new ValidationResult($this->schema, $this->bits, $record * $this->schema->getWordCount(), $this->rejections->get($record));
+    }
+
+    /**
+     * Return the schema that produced this result.
+     *
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function getSchema(): CompiledSchema {
+        return $this->schema;
+    }
+
+    /**
+     * Return true if the rule at the schema wide index failed for a record.
+     *
+     * @param int $record
+     * @param int $bit
+     * @return bool
+     */
+    public function hasFailed(int $record, int $bit): bool {
+        return (($this->bits[$record * $this->schema->getWordCount() + ($bit >> 6)] & (1 << ($bit & 63))) !== 0);
+    }
+
+    /**
+     * Return true if every record passed validation.
+     *
+     * @return bool
+     */
+    public function passed(): bool {
+        if (!$this->rejections->isEmpty()) {
+            return false;
+        }
+
+        foreach ($this->bits as $word) {
+            if ($word !== 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Return true if a single record passed validation.
+     *
+     * @param int $record
+     * @return bool
+     */
+    public function recordPassed(int $record): bool {
+        if ($this->rejections->contains($record)) {
+            return false;
+        }
+
+        $words = $this->schema->getWordCount();
+
+        for ($i = $record * $words, $end = $i + $words; $i < $end; $i++) {
+            if ($this->bits[$i] !== 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,26 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Provides bulk variants of constraints, which validate a whole column of values in a single call.
+ *
+ * @package Titon\Validate
+ */
+interface BulkConstraintProvider {
+
+    /**
+     * Return a map of bulk constraint callbacks with the key being the rule name.
+     * Each callback receives a list of values followed by the rule options,
+     * and must return a list of booleans in the same order as the values.
+     *
+     * @return \Titon\Validate\BulkConstraintMap
+     */
+    public function getBulkConstraints(): BulkConstraintMap;
+
+}
@@ -0,0 +1,2739 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+use Titon\Validate\Exception\InvalidPatternException;
+use Titon\Validate\Exception\MissingConstraintException;
+use Titon\Validate\Exception\MissingMessageException;
+use \Indexish;
+use \InvalidArgumentException;
+
+/**
+ * An immutable snapshot of a validator's fields, titles, rules, constraints and messages.
+ * A schema is built once (usually per worker) and can validate any number of data sets
+ * without mutating state, as each call returns its own result.
+ *
+ * @package Titon\Validate
+ */
+class CompiledSchema {
+
+    /**
+     * Version of the export format, which is raised whenever the layout of exported schemas changes.
+     *
+     * @var int
+     */
+    const int EXPORT_VERSION = 2;
+
+    /**
+     * When validation should stop after a rule fails.
+     *
+     * @var \Titon\Validate\BailMode
+     */
+    protected BailMode $bail = BailMode::NONE;
+
+    /**
+     * Cache of async constraint results shared between validation passes.
+     *
+     * @var \Titon\Validate\ConstraintCache
+     */
+    protected ?ConstraintCache $cache = null;
+
+    /**
+     * Compiled conditions, where a field's condition index points into this list.
+     *
+     * @var \Titon\Validate\CompiledConditionList
+     */
+    protected CompiledConditionList $conditions;
+
+    /**
+     * Whether rules of a field are run cheapest first when a bail mode is set.
+     *
+     * @var bool
+     */
+    protected bool $costOrdering = false;
+
+    /**
+     * Whether cost ordering reports the same rule as the definition order, or the first failure it finds.
+     *
+     * @var bool
+     */
+    protected bool $costStrict = true;
+
+    /**
+     * Compiled fields in the order they were defined.
+     *
+     * @var \Titon\Validate\CompiledFieldList
+     */
+    protected CompiledFieldList $fields;
+
+    /**
+     * Mapping of top level data keys to the indices of the fields that have to be re-validated when the key changes.
+     *
+     * @var ImmMap<string, ImmVector<int>>
+     */
+    protected ImmMap<string, ImmVector<int>> $dependents;
+
+    /**
+     * Mapping of field names to their index in the compiled field list.
+     *
+     * @var ImmMap<string, int>
+     */
+    protected ImmMap<string, int> $index;
+
+    /**
+     * Collector of timing and failure counters, if instrumentation is enabled.
+     *
+     * @var \Titon\Validate\Instrumentation
+     */
+    protected ?Instrumentation $instrumentation = null;
+
+    /**
+     * Maximum number of items in the record and in any collection nested within the schema's fields. A negative value disables the limit.
+     *
+     * @var int
+     */
+    protected int $maxCollectionSize = -1;
+
+    /**
+     * Maximum number of collections nested within each other below the record, within the schema's fields. A negative value disables the limit.
+     *
+     * @var int
+     */
+    protected int $maxDepth = -1;
+
+    /**
+     * Maximum length in bytes of any string within the schema's fields. A negative value disables the limit.
+     *
+     * @var int
+     */
+    protected int $maxStringLength = -1;
+
+    /**
+     * Maximum number of keys in the data that are not part of the schema. A negative value disables the limit.
+     *
+     * @var int
+     */
+    protected int $maxUnknownKeys = -1;
+
+    /**
+     * Maximum number of results memoized per pure rule during a batch. Zero disables memoization.
+     *
+     * @var int
+     */
+    protected int $memoLimit = 1024;
+
+    /**
+     * Name of the schema when reporting instrumentation counters.
+     *
+     * @var string
+     */
+    protected string $name = '';
+
+    /**
+     * Order in which the rules of each field are run when ordering by cost, as indices into the field's rules.
+     *
+     * @var ImmVector<ImmVector<int>>
+     */
+    protected ImmVector<ImmVector<int>> $order;
+
+    /**
+     * Index of each field's first rule within the flattened list of rules.
+     *
+     * @var ImmVector<int>
+     */
+    protected ImmVector<int> $offsets;
+
+    /**
+     * Indices of fields whose names are nested paths.
+     *
+     * @var ImmVector<int>
+     */
+    protected ImmVector<int> $paths;
+
+    /**
+     * Top level keys of the data that are referenced by the schema.
+     *
+     * @var ImmSet<string>
+     */
+    protected ImmSet<string> $roots;
+
+    /**
+     * Flattened list of rules, mapping the schema wide rule index to a field index and rule index.
+     *
+     * @var ImmVector<Pair<int, int>>
+     */
+    protected ImmVector<Pair<int, int>> $ruleIndex;
+
+    /**
+     * The view of the current record that cross-field rules are bound to, or null if the schema has none.
+     *
+     * @var \Titon\Validate\RecordView
+     */
+    protected ?RecordView $view;
+
+    /**
+     * Indices of fields whose conditions do not declare the keys they read, which are re-validated on every change.
+     *
+     * @var ImmVector<int>
+     */
+    protected ImmVector<int> $volatile;
+
+    /**
+     * Whether the compiled fields or the data is iterated during validation.
+     *
+     * @var \Titon\Validate\WalkMode
+     */
+    protected WalkMode $walk = WalkMode::SCHEMA;
+
+    /**
+     * Number of 64-bit words required to store one bit per rule.
+     *
+     * @var int
+     */
+    protected int $words;
+
+    /**
+     * Store the compiled fields and conditions, and build the field and rule indices.
+     *
+     * @param \Titon\Validate\CompiledFieldList $fields
+     * @param \Titon\Validate\CompiledConditionList $conditions
+     * @throws \InvalidArgumentException
+     */
+    public function __construct(CompiledFieldList $fields, CompiledConditionList $conditions = ImmVector {}) {
+        $bound = Vector {};
+        $view = null;
+        $dependents = Map {};
+        $volatile = Vector {};
+        $index = Map {};
+        $offsets = Vector {};
+        $order = Vector {};
+        $paths = Vector {};
+        $roots = Set {};
+        $rules = Vector {};
+
+        foreach ($fields as $i => $field) {
+            $references = Set {};
+
+            // Error codes store the rule index in the low 16 bits
+            if ($field['rules']->count() > 0x10000) {
+                throw new InvalidArgumentException(sprintf('Field %s can not have more than 65536 rules', $field['field']));
+            }
+
+            foreach ($field['rules'] as $rule) {
+                $references->addAll($rule['references']);
+            }
+
+            // Cross-field rules receive the record view as their first argument
+            if (!$references->isEmpty()) {
+                $view = $view ?: new RecordView();
+                $field['rules'] = static::bindView($field['rules'], $view);
+                $typed = $field['typed'];
+
+                if ($typed !== null) {
+                    $field['typed'] = static::bindView($typed, $view);
+                }
+            }
+
+            $bound[] = $field;
+            $index[$field['field']] = $i;
+            $offsets[] = $rules->count();
+            $roots[] = $field['field'];
+
+            if ($field['path'] !== null) {
+                $paths[] = $i;
+                $roots[] = $field['path'][0];
+            }
+
+            foreach ($field['rules'] as $r => $rule) {
+                $rules[] = Pair {$i, $r};
+            }
+
+            // Stable sort by cost, so rules of equal cost keep their definition order
+            $sorted = $field['rules']->keys()->toArray();
+            usort($sorted, ($a, $b) ==> {
+                $diff = $field['rules'][$a]['cost'] - $field['rules'][$b]['cost'];
+
+                return ($diff < 0) ? -1 : (($diff > 0) ? 1 : ($a - $b));
+            });
+
+            $order[] = new ImmVector($sorted);
+
+            // A field depends on its own key, its root key, the fields its rules reference, and the keys read by its conditions
+            $keys = Set {$field['field']};
+
+            if ($field['path'] !== null) {
+                $keys[] = $field['path'][0];
+            }
+
+            foreach ($references as $reference) {
+                $path = static::splitPath($reference);
+                $keys[] = ($path !== null) ? $path[0] : $reference;
+            }
+
+            for ($c = $field['condition']; $c >= 0; $c = $conditions[$c]['parent']) {
+                if ($conditions[$c]['keys']->isEmpty()) {
+                    $volatile[] = $i;
+                    break;
+                }
+
+                $keys->addAll($conditions[$c]['keys']);
+            }
+
+            foreach ($keys as $key) {
+                if (!$dependents->contains($key)) {
+                    $dependents[$key] = Vector {};
+                }
+
+                $dependents[$key][] = $i;
+            }
+        }
+
+        $this->fields = $bound->toImmVector();
+        $this->conditions = $conditions;
+        $this->dependents = $dependents->map($list ==> $list->toImmVector())->toImmMap();
+        $this->index = $index->toImmMap();
+        $this->offsets = $offsets->toImmVector();
+        $this->order = $order->toImmVector();
+        $this->paths = $paths->toImmVector();
+        $this->roots = $roots->toImmSet();
+        $this->ruleIndex = $rules->toImmVector();
+        $this->view = $view;
+        $this->volatile = $volatile->toImmVector();
+        $this->words = (int) ceil($rules->count() / 64);
+    }
+
+    /**
+     * Bind cross-field rules to a view of their own, so that schemas derived with the `with*()` methods
+     * never share the record being validated with each other.
+     */
+    public function __clone(): void {
+        if ($this->view === null) {
+            return;
+        }
+
+        $view = new RecordView();
+
+        $this->fields = $this->fields->map($field ==> {
+            $field['rules'] = static::bindView($field['rules'], $view);
+            $typed = $field['typed'];
+
+            if ($typed !== null) {
+                $field['typed'] = static::bindView($typed, $view);
+            }
+
+            return $field;
+        });
+
+        $this->view = $view;
+    }
+
+    /**
+     * Allocate a zeroed failure bitset large enough for the defined number of records.
+     *
+     * @param int $records
+     * @return Vector<int>
+     */
+    public function allocateBits(int $records = 1): Vector<int> {
+        $bits = Vector {};
+        $bits->resize($records * $this->words, 0);
+
+        return $bits;
+    }
+
+    /**
+     * Allocate the state of every condition for a single record, or return null if the schema has no conditions.
+     * Each state is 0 while unknown, 1 when the condition applies, and 2 when it does not.
+     *
+     * @return Vector<int>
+     */
+    public function allocateConditions(): ?Vector<int> {
+        if ($this->conditions->isEmpty()) {
+            return null;
+        }
+
+        $state = Vector {};
+        $state->resize($this->conditions->count(), 0);
+
+        return $state;
+    }
+
+    /**
+     * Allocate an empty memo list with one map per rule, or return null if memoization is disabled.
+     *
+     * @return \Titon\Validate\MemoList
+     */
+    public function allocateMemo(): ?MemoList {
+        if ($this->memoLimit <= 0) {
+            return null;
+        }
+
+        $memo = Vector {};
+
+        foreach ($this->ruleIndex as $bit => $rule) {
+            $memo[] = Map {};
+        }
+
+        return $memo;
+    }
+
+    /**
+     * Return true if the field at the index applies to the record. A field's condition, and the conditions it
+     * is nested in, are evaluated the first time they are needed and only once per record.
+     * A condition is never evaluated when its parent does not apply.
+     *
+     * @param int $index
+     * @param \Titon\Validate\DataMap $data
+     * @param Vector<int> $state
+     * @return bool
+     */
+    public function applies(int $index, DataMap $data, ?Vector<int> $state): bool {
+        $condition = $this->fields[$index]['condition'];
+
+        if ($condition < 0 || $state === null) {
+            return true;
+        }
+
+        return $this->evaluate($condition, $data, $state);
+    }
+
+    /**
+     * Reduce the failures of a record found by running every rule to the failures reported under the bail mode,
+     * which are the first failure of each field, or the first failure of the record.
+     *
+     * @param Vector<int> $bits
+     * @param int $base
+     */
+    public function applyBail(Vector<int> $bits, int $base = 0): void {
+        if ($this->bail === BailMode::ALL) {
+            $this->keepFirstFailure($bits, $base);
+
+        } else if ($this->bail === BailMode::FIELD) {
+            for ($f = 0, $count = $this->fields->count(); $f < $count; $f++) {
+                $this->keepFirstFieldFailure($f, $bits, $base);
+            }
+        }
+    }
+
+    /**
+     * Reduce the failures of a record found by running every rule against every value to the failures reported under the bail mode,
+     * honouring the walk mode and cost ordering. Positions of the first failing value are mapped by rule bit,
+     * so that a wildcard field reports the first rule to fail for its first failing value, where a missing position is the first value.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @param Vector<int> $bits
+     * @param Map<int, int> $positions
+     */
+    public function applyRecordBail(DataMap $data, Vector<int> $bits, Map<int, int> $positions): void {
+        if ($this->bail === BailMode::NONE) {
+            return;
+        }
+
+        $ordered = ($this->costOrdering && !$this->costStrict);
+
+        foreach ($this->fields as $f => $compiled) {
+            $offset = $this->offsets[$f];
+            $first = -1;
+            $position = -1;
+
+            foreach (($ordered ? $this->order[$f] : $compiled['rules']->keys()) as $r) {
+                $bit = $offset + $r;
+
+                if (($bits[$bit >> 6] & (1 << ($bit & 63))) === 0) {
+                    continue;
+                }
+
+                $at = (int) idx($positions, $bit, 0);
+
+                if ($first < 0 || $at < $position) {
+                    $first = $bit;
+                    $position = $at;
+                }
+            }
+
+            if ($first < 0) {
+                continue;
+            }
+
+            for ($bit = $offset, $end = $offset + $compiled['rules']->count(); $bit < $end; $bit++) {
+                if ($bit !== $first) {
+                    $bits[$bit >> 6] &= ~(1 << ($bit & 63));
+                }
+            }
+        }
+
+        // Each field has a single failure left, so the lowest bit is the first failed field
+        if ($this->bail === BailMode::ALL) {
+            if ($this->walk === WalkMode::DATA) {
+                $this->keepFirstWalkedFailure($data, $bits, 0);
+            } else {
+                $this->keepFirstFailure($bits, 0);
+            }
+        }
+    }
+
+    /**
+     * Point the record view of cross-field rules at a record, before its rules are run.
+     *
+     * @param \Titon\Validate\DataMap $data
+     */
+    public function bindRecord(DataMap $data): void {
+        if ($this->view !== null) {
+            $this->view->reset($data);
+        }
+    }
+
+    /**
+     * Validate a record and set a bit for every failing rule, starting at the defined word offset.
+     * Return the reason if the record was rejected before any rules were run, or null otherwise.
+     *
+     * Results of pure rules are looked up in and added to the memo list when one is provided.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @param Vector<int> $bits
+     * @param int $base
+     * @param \Titon\Validate\MemoList $memo
+     * @return string
+     */
+    public function check(DataMap $data, Vector<int> $bits, int $base = 0, ?MemoList $memo = null): ?string {
+        $rejection = $this->reject($data);
+
+        if ($rejection !== null) {
+            return $rejection;
+        }
+
+        $this->bindRecord($data);
+
+        // Instrumentation is decided once per record, so untimed records take the same path as without it
+        $timed = ($this->instrumentation !== null && $this->instrumentation->sample());
+        $state = $this->allocateConditions();
+
+        // Cost scales with the number of fields in the schema
+        if ($this->walk === WalkMode::SCHEMA) {
+            foreach ($this->fields as $i => $compiled) {
+                $field = $compiled['field'];
+
+                if ($compiled['condition'] >= 0 && !$this->applies($i, $data, $state)) {
+                    continue;
+
+                } else if ($data->contains($field)) {
+                    if (!$this->checkField($i, $data[$field], $bits, $base, $memo, $timed)) {
+                        break;
+                    }
+                } else if ($compiled['path'] !== null && !$this->checkPath($i, $data, $bits, $base, $memo, $timed)) {
+                    break;
+                }
+            }
+
+        // Cost scales with the number of keys in the data
+        } else {
+            $continue = true;
+
+            foreach ($data as $field => $value) {
+                $index = $this->index->get($field);
+
+                if ($index !== null && $this->applies($index, $data, $state) && !$this->checkField($index, $value, $bits, $base, $memo, $timed)) {
+                    $continue = false;
+                    break;
+                }
+            }
+
+            // Nested paths cannot be found by key, so they are walked afterwards
+            if ($continue) {
+                foreach ($this->paths as $index) {
+                    if (!$data->contains($this->fields[$index]['field']) && $this->applies($index, $data, $state) && !$this->checkPath($index, $data, $bits, $base, $memo, $timed)) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        $this->releaseRecord();
+
+        return null;
+    }
+
+    /**
+     * Validate a single value against the rules of a field and set a bit for every failing rule.
+     * Return false if validation should stop entirely.
+     *
+     * @param int $index
+     * @param mixed $value
+     * @param Vector<int> $bits
+     * @param int $base
+     * @param \Titon\Validate\MemoList $memo
+     * @param bool $timed
+     * @return bool
+     */
+    protected function checkField(int $index, mixed $value, Vector<int> $bits, int $base, ?MemoList $memo = null, bool $timed = false): bool {
+        $bail = $this->bail;
+
+        if ($this->costOrdering && $bail !== BailMode::NONE) {
+            return $this->checkFieldOrdered($index, $value, $bits, $base, $memo, $timed);
+        }
+
+        if ($timed) {
+            return $this->checkFieldTimed($index, $value, $bits, $base, $memo);
+        }
+
+        $offset = $this->offsets[$index];
+
+        // Only the rule is recorded, messages are rendered when read
+        foreach ($this->rulesFor($index, $value) as $i => $rule) {
+            $bit = $offset + $i;
+
+            if ($memo !== null && $rule['pure']) {
+                $passed = $this->invokeMemoized($rule, $value, $memo[$bit]);
+            } else {
+                $passed = static::invoke($rule, $value);
+            }
+
+            if (!$passed) {
+                $bits[$base + ($bit >> 6)] |= (1 << ($bit & 63));
+
+                if ($bail === BailMode::FIELD) {
+                    break;
+                } else if ($bail === BailMode::ALL) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Validate a single value like checkField() with a bail mode, but run the rules cheapest first.
+     *
+     * When strict, the same rule is reported as with the definition order: a failure only skips the rules defined
+     * after it, while rules defined before it still run, and the failure with the lowest definition index is recorded.
+     * Otherwise the first failure found is recorded and the remaining rules are skipped.
+     * When timed, the time and outcome of every constraint call are recorded like checkFieldTimed().
+     *
+     * @param int $index
+     * @param mixed $value
+     * @param Vector<int> $bits
+     * @param int $base
+     * @param \Titon\Validate\MemoList $memo
+     * @param bool $timed
+     * @return bool
+     */
+    protected function checkFieldOrdered(int $index, mixed $value, Vector<int> $bits, int $base, ?MemoList $memo = null, bool $timed = false): bool {
+        $offset = $this->offsets[$index];
+        $rules = $this->rulesFor($index, $value);
+        $strict = $this->costStrict;
+        $instrumentation = $timed ? $this->instrumentation : null;
+        $first = -1;
+
+        foreach ($this->order[$index] as $i) {
+            if ($first >= 0 && $i > $first) {
+                continue;
+            }
+
+            $rule = $rules[$i];
+            $start = ($instrumentation !== null) ? microtime(true) : 0.0;
+
+            if ($memo !== null && $rule['pure']) {
+                $passed = $this->invokeMemoized($rule, $value, $memo[$offset + $i]);
+            } else {
+                $passed = static::invoke($rule, $value);
+            }
+
+            if ($instrumentation !== null) {
+                $instrumentation->recordCall($this->name, $offset + $i, $passed, microtime(true) - $start);
+            }
+
+            if (!$passed) {
+                $first = $i;
+
+                if (!$strict) {
+                    break;
+                }
+            }
+        }
+
+        if ($first < 0) {
+            return true;
+        }
+
+        $bit = $offset + $first;
+        $bits[$base + ($bit >> 6)] |= (1 << ($bit & 63));
+
+        return ($this->bail !== BailMode::ALL);
+    }
+
+    /**
+     * Validate a single value like checkField(), while recording the time and outcome of every constraint call.
+     * Cost ordered fields are timed by checkFieldOrdered() instead.
+     *
+     * @param int $index
+     * @param mixed $value
+     * @param Vector<int> $bits
+     * @param int $base
+     * @param \Titon\Validate\MemoList $memo
+     * @return bool
+     */
+    protected function checkFieldTimed(int $index, mixed $value, Vector<int> $bits, int $base, ?MemoList $memo = null): bool {
+        $bail = $this->bail;
+        $offset = $this->offsets[$index];
+        $instrumentation = $this->instrumentation;
+
+        if ($instrumentation === null) {
+            return $this->checkField($index, $value, $bits, $base, $memo);
+        }
+
+        foreach ($this->rulesFor($index, $value) as $i => $rule) {
+            $bit = $offset + $i;
+            $start = microtime(true);
+
+            if ($memo !== null && $rule['pure']) {
+                $passed = $this->invokeMemoized($rule, $value, $memo[$bit]);
+            } else {
+                $passed = static::invoke($rule, $value);
+            }
+
+            $instrumentation->recordCall($this->name, $bit, $passed, microtime(true) - $start);
+
+            if (!$passed) {
+                $bits[$base + ($bit >> 6)] |= (1 << ($bit & 63));
+
+                if ($bail === BailMode::FIELD) {
+                    break;
+                } else if ($bail === BailMode::ALL) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Walk a nested path of a field and validate every value it resolves to.
+     * When bailing on the field, the values after the first failing value are skipped.
+     * Return false if validation should stop entirely.
+     *
+     * @param int $index
+     * @param \Titon\Validate\DataMap $data
+     * @param Vector<int> $bits
+     * @param int $base
+     * @param \Titon\Validate\MemoList $memo
+     * @param bool $timed
+     * @return bool
+     */
+    protected function checkPath(int $index, DataMap $data, Vector<int> $bits, int $base, ?MemoList $memo = null, bool $timed = false): bool {
+        $path = $this->fields[$index]['path'];
+
+        if ($path === null) {
+            return true;
+        }
+
+        foreach (static::walkPath($data, $path) as $value) {
+            if (!$this->checkField($index, $value, $bits, $base, $memo, $timed)) {
+                return false;
+            }
+
+            if ($this->bail === BailMode::FIELD && $this->isFieldFailed($index, $bits, $base)) {
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Return the number of keys in the data that are not part of the schema.
+     * Only the keys referenced by the schema are probed, so the cost does not depend on the size of the data.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @return int
+     */
+    public function countUnknownKeys(DataMap $data): int {
+        $known = 0;
+
+        foreach ($this->roots as $root) {
+            if ($data->contains($root)) {
+                $known++;
+            }
+        }
+
+        return $data->count() - $known;
+    }
+
+    /**
+     * Evaluate a condition for a record, unless its state is already known.
+     *
+     * @param int $condition
+     * @param \Titon\Validate\DataMap $data
+     * @param Vector<int> $state
+     * @return bool
+     */
+    protected function evaluate(int $condition, DataMap $data, Vector<int> $state): bool {
+        $known = $state[$condition];
+
+        if ($known !== 0) {
+            return ($known === 1);
+        }
+
+        $compiled = $this->conditions[$condition];
+        $predicate = $compiled['predicate'];
+        $parent = $compiled['parent'];
+        $applies = (($parent < 0 || $this->evaluate($parent, $data, $state)) && $predicate($data));
+
+        $state[$condition] = $applies ? 1 : 2;
+
+        return $applies;
+    }
+
+    /**
+     * Export the schema into a compact list of plain values that can be serialized.
+     * Callbacks cannot be serialized, so only the rule names are kept and constraints are bound again on import,
+     * while parsed options and pre-tokenized messages are kept as is. The export is tagged with the format version.
+     *
+     * @return array<string, mixed>
+     */
+    public function export(): array<string, mixed> {
+        $fields = [];
+
+        foreach ($this->fields as $field) {
+            $rules = [];
+
+            foreach ($field['rules'] as $rule) {
+                $rules[] = [
+                    $rule['rule'],
+                    $rule['key'],
+                    $rule['message'],
+                    $rule['options']->toArray(),
+                    $rule['references']->isEmpty() ? $rule['arguments'] : array_slice($rule['arguments'], 1),
+                    $rule['pure'],
+                    $rule['cost'],
+                    $rule['pattern'],
+                    $rule['template'],
+                    $rule['tokens']->toArray()
+                ];
+            }
+
+            $fields[] = [$field['field'], $field['title'], $rules, ($field['condition'] >= 0) ? $this->conditions[$field['condition']]['name'] : '', $field['type']];
+        }
+
+        return [
+            'version' => static::EXPORT_VERSION,
+            'bail' => $this->bail,
+            'walk' => $this->walk,
+            'costOrdering' => $this->costOrdering,
+            'costStrict' => $this->costStrict,
+            'maxUnknownKeys' => $this->maxUnknownKeys,
+            'maxCollectionSize' => $this->maxCollectionSize,
+            'maxDepth' => $this->maxDepth,
+            'maxStringLength' => $this->maxStringLength,
+            'memoLimit' => $this->memoLimit,
+            'fields' => $fields
+        ];
+    }
+
+    /**
+     * Format an error message by rendering the rule's pre-tokenized template.
+     * When a catalog is defined and has a message for the rule, its template is rendered instead.
+     *
+     * @param \Titon\Validate\CompiledField $field
+     * @param \Titon\Validate\CompiledRule $rule
+     * @param \Titon\Validate\MessageCatalog $catalog
+     * @return string
+     * @throws \Titon\Validate\Exception\MissingMessageException
+     */
+    public function formatMessage(CompiledField $field, CompiledRule $rule, ?MessageCatalog $catalog = null): string {
+        if ($catalog !== null) {
+            $template = $catalog->getTemplate($field['field'], $rule['rule']);
+
+            if ($template !== null) {
+                return $template->render($rule['tokens']);
+            }
+        }
+
+        if (!$rule['message']) {
+            throw new MissingMessageException(sprintf('Error message for rule %s does not exist', $rule['rule']));
+        }
+
+        return $rule['template']->render($rule['tokens']);
+    }
+
+    /**
+     * Validate the data like validate(), but run all async constraints concurrently.
+     * Sync constraints are executed inline while the async constraints are being queued,
+     * so the total latency is that of the slowest async constraint rather than their sum.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @return Awaitable<\Titon\Validate\ValidationResult>
+     */
+    public async function genValidate(DataMap $data): Awaitable<ValidationResult> {
+        $batch = await $this->genValidateBatch(Vector {$data});
+
+        return $batch->getResult(0);
+    }
+
+    /**
+     * Validate many records while running async constraints concurrently.
+     * Async checks from every record are collected into one queue, where checks for the same rule and options
+     * are coalesced into a single bulk call, and results can be served from the constraint cache.
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return Awaitable<\Titon\Validate\BatchResult>
+     */
+    public async function genValidateBatch(Traversable<DataMap> $records): Awaitable<BatchResult> {
+        $records = new Vector($records);
+        $count = $records->count();
+        $words = $this->words;
+        $bail = $this->bail;
+        $bits = $this->allocateBits($count);
+        $ordered = ($this->costOrdering && $bail !== BailMode::NONE);
+        $strict = ($ordered && $this->costStrict);
+        $walked = ($this->walk === WalkMode::DATA && $bail === BailMode::ALL);
+        $rejections = Map {};
+        $queue = new AsyncConstraintQueue($this->cache);
+        $targets = Vector {};
+        $memo = $this->allocateMemo();
+
+        // Which field fails first depends on the key order of each record, so it's resolved afterwards like validateColumns()
+        if ($walked) {
+            $bail = BailMode::FIELD;
+        }
+
+        foreach ($records as $r => $data) {
+            $rejection = $this->reject($data);
+
+            if ($rejection !== null) {
+                $rejections[$r] = $rejection;
+                continue;
+            }
+
+            $base = $r * $words;
+
+            $state = $this->allocateConditions();
+            $this->bindRecord($data);
+
+            foreach ($this->fields as $f => $compiled) {
+                if (!$this->applies($f, $data, $state)) {
+                    continue;
+                }
+
+                $offset = $this->offsets[$f];
+                $failed = false;
+
+                foreach ($this->resolve($compiled, $data) as $value) {
+                    $first = -1;
+
+                    // Rules run in cost order like checkFieldOrdered(), where strict ordering still runs the rules defined before a failure
+                    foreach (($ordered ? $this->order[$f] : $compiled['rules']->keys()) as $i) {
+                        if ($strict && $first >= 0 && $i > $first) {
+                            continue;
+                        }
+
+                        $rule = $compiled['rules'][$i];
+
+                        if ($rule['async'] !== null) {
+                            $queue->add($rule, $value);
+                            $targets[] = Pair {$base, $offset + $i};
+
+                        } else if (!(($memo !== null && $rule['pure']) ? $this->invokeMemoized($rule, $value, $memo[$offset + $i]) : static::invoke($rule, $value))) {
+                            $bit = $offset + $i;
+                            $bits[$base + ($bit >> 6)] |= (1 << ($bit & 63));
+                            $failed = true;
+                            $first = $i;
+
+                            // Async rules defined after the failure are never queued
+                            if ($bail !== BailMode::NONE && !$strict) {
+                                break;
+                            }
+                        }
+                    }
+
+                    // Only the first failing value of a field is reported when bailing
+                    if ($failed && $bail !== BailMode::NONE) {
+                        break;
+                    }
+                }
+
+                if ($failed && $bail === BailMode::ALL) {
+                    break;
+                }
+            }
+        }
+
+        $this->releaseRecord();
+
+        $async = ($queue->count() > 0);
+
+        if ($async) {
+            $results = await $queue->gen();
+
+            foreach ($results as $slot => $passed) {
+                if (!$passed) {
+                    $target = $targets[$slot];
+                    $bit = $target[1];
+                    $bits[$target[0] + ($bit >> 6)] |= (1 << ($bit & 63));
+                }
+            }
+        }
+
+        // Async rules finish in any order, and strict ordering may record several failures,
+        // so only report the first failure of each field in definition order, and the first failed field in walk order
+        if ($walked) {
+            foreach ($records as $r => $data) {
+                for ($f = 0, $fields = $this->fields->count(); $f < $fields; $f++) {
+                    $this->keepFirstFieldFailure($f, $bits, $r * $words);
+                }
+
+                $this->keepFirstWalkedFailure($data, $bits, $r * $words);
+            }
+
+        } else if ($async || $strict) {
+            for ($r = 0; $r < $count; $r++) {
+                $this->applyBail($bits, $r * $words);
+            }
+        }
+
+        return new BatchResult($this, $bits, $count, $rejections);
+    }
+
+    /**
+     * Return the indices of the fields that have to be re-validated when the keys of the delta change,
+     * in the order they are first affected.
+     *
+     * @param \Titon\Validate\DataMap $delta
+     * @return Set<int>
+     */
+    public function getAffectedFields(DataMap $delta): Set<int> {
+        $affected = Set {};
+
+        if ($delta->isEmpty()) {
+            return $affected;
+        }
+
+        foreach ($delta as $key => $value) {
+            $dependents = $this->dependents->get($key);
+
+            if ($dependents !== null) {
+                $affected->addAll($dependents);
+            }
+        }
+
+        return $affected->addAll($this->volatile);
+    }
+
+    /**
+     * Return the bail mode.
+     *
+     * @return \Titon\Validate\BailMode
+     */
+    public function getBailMode(): BailMode {
+        return $this->bail;
+    }
+
+    /**
+     * Return the cache used for async constraint results.
+     *
+     * @return \Titon\Validate\ConstraintCache
+     */
+    public function getCache(): ?ConstraintCache {
+        return $this->cache;
+    }
+
+    /**
+     * Return the error code of the rule at the schema wide index.
+     *
+     * @param int $bit
+     * @return int
+     */
+    public function getCode(int $bit): int {
+        $rule = $this->ruleIndex[$bit];
+
+        return static::packCode($rule[0], $rule[1]);
+    }
+
+    /**
+     * Return the compiled conditions.
+     *
+     * @return \Titon\Validate\CompiledConditionList
+     */
+    public function getConditions(): CompiledConditionList {
+        return $this->conditions;
+    }
+
+    /**
+     * Return a compiled field by name, or null if it does not exist.
+     *
+     * @param string $field
+     * @return \Titon\Validate\CompiledField
+     */
+    public function getField(string $field): ?CompiledField {
+        $index = $this->index->get($field);
+
+        return ($index === null) ? null : $this->fields[$index];
+    }
+
+    /**
+     * Return the compiled field at the defined index.
+     *
+     * @param int $index
+     * @return \Titon\Validate\CompiledField
+     */
+    public function getFieldAt(int $index): CompiledField {
+        return $this->fields[$index];
+    }
+
+    /**
+     * Return all compiled fields.
+     *
+     * @return \Titon\Validate\CompiledFieldList
+     */
+    public function getFields(): CompiledFieldList {
+        return $this->fields;
+    }
+
+    /**
+     * Execute a rule's constraint against a value. The options have been materialized at compile time,
+     * so the common arities are dispatched as direct calls without building an argument list.
+     *
+     * @param \Titon\Validate\CompiledRule $rule
+     * @param mixed $value
+     * @return bool
+     */
+    public static function invoke(CompiledRule $rule, mixed $value): bool {
+        $constraint = $rule['constraint'];
+        $args = $rule['arguments'];
+
+        // UNSAFE
+        // Since constraints accept a variable number of options
+        switch ($rule['arity']) {
+            case 0:
+                return (bool) $constraint($value);
+            case 1:
+                return (bool) $constraint($value, $args[0]);
+            case 2:
+                return (bool) $constraint($value, $args[0], $args[1]);
+            case 3:
+                return (bool) $constraint($value, $args[0], $args[1], $args[2]);
+            default:
+                array_unshift($args, $value);
+
+                return (bool) call_user_func_array($constraint, $args);
+        }
+    }
+
+    /**
+     * Return the instrumentation collector, if enabled.
+     *
+     * @return \Titon\Validate\Instrumentation
+     */
+    public function getInstrumentation(): ?Instrumentation {
+        return $this->instrumentation;
+    }
+
+    /**
+     * Return the maximum number of items allowed in the record and in any collection nested within the schema's fields.
+     *
+     * @return int
+     */
+    public function getMaxCollectionSize(): int {
+        return $this->maxCollectionSize;
+    }
+
+    /**
+     * Return the maximum number of collections allowed to be nested below the record, within the schema's fields.
+     *
+     * @return int
+     */
+    public function getMaxDepth(): int {
+        return $this->maxDepth;
+    }
+
+    /**
+     * Return the maximum length in bytes allowed for any string within the schema's fields.
+     *
+     * @return int
+     */
+    public function getMaxStringLength(): int {
+        return $this->maxStringLength;
+    }
+
+    /**
+     * Return the maximum number of unknown keys allowed in the data.
+     *
+     * @return int
+     */
+    public function getMaxUnknownKeys(): int {
+        return $this->maxUnknownKeys;
+    }
+
+    /**
+     * Return the maximum number of results memoized per pure rule during a batch.
+     *
+     * @return int
+     */
+    public function getMemoLimit(): int {
+        return $this->memoLimit;
+    }
+
+    /**
+     * Return the name used when reporting instrumentation counters.
+     *
+     * @return string
+     */
+    public function getName(): string {
+        return $this->name;
+    }
+
+    /**
+     * Return the field index and rule index for a schema wide rule index.
+     *
+     * @param int $bit
+     * @return Pair<int, int>
+     */
+    public function getRuleAt(int $bit): Pair<int, int> {
+        return $this->ruleIndex[$bit];
+    }
+
+    /**
+     * Return the total number of rules across all fields.
+     *
+     * @return int
+     */
+    public function getRuleCount(): int {
+        return $this->ruleIndex->count();
+    }
+
+    /**
+     * Return the index of a field's first rule within the flattened list of rules.
+     *
+     * @param int $index
+     * @return int
+     */
+    public function getRuleOffset(int $index): int {
+        return $this->offsets[$index];
+    }
+
+    /**
+     * Return the order in which the rules of a field are run when ordering by cost, as indices into the field's rules.
+     *
+     * @param int $index
+     * @return ImmVector<int>
+     */
+    public function getRuleOrder(int $index): ImmVector<int> {
+        return $this->order[$index];
+    }
+
+    /**
+     * Return whether the compiled fields or the data is iterated.
+     *
+     * @return \Titon\Validate\WalkMode
+     */
+    public function getWalkMode(): WalkMode {
+        return $this->walk;
+    }
+
+    /**
+     * Return the number of 64-bit words used to store the failures of one record.
+     *
+     * @return int
+     */
+    public function getWordCount(): int {
+        return $this->words;
+    }
+
+    /**
+     * Return the reason a value exceeds the payload limits, or null if it does not.
+     * A collection is iterated no further than the size limit, and not at all when it exceeds the depth limit.
+     * Iterators cannot be rewound once consumed, so they are left for the constraints to read.
+     *
+     * @param mixed $value
+     * @param int $depth
+     * @return string
+     */
+    protected function inspect(mixed $value, int $depth): ?string {
+        if (is_string($value)) {
+            if ($this->maxStringLength >= 0 && strlen($value) > $this->maxStringLength) {
+                return sprintf('Data contains a string longer than %s bytes', $this->maxStringLength);
+            }
+
+        } else if (($value instanceof Traversable && !($value instanceof Iterator)) || is_array($value)) {
+            if ($this->maxDepth >= 0 && $depth > $this->maxDepth) {
+                return sprintf('Data is nested deeper than %s levels', $this->maxDepth);
+            }
+
+            $size = 0;
+
+            foreach ($value as $child) {
+                if ($this->maxCollectionSize >= 0 && ++$size > $this->maxCollectionSize) {
+                    return sprintf('Data contains a collection of more than %s items', $this->maxCollectionSize);
+                }
+
+                $rejection = $this->inspect($child, $depth + 1);
+
+                if ($rejection !== null) {
+                    return $rejection;
+                }
+            }
+        }
+
+        return null;
+    }
+
+    /**
+     * Execute a pure rule's constraint, reusing the result of a previous call with the same string or integer value.
+     * New results are only memoized while the memo is below the schema's limit.
+     *
+     * @param \Titon\Validate\CompiledRule $rule
+     * @param mixed $value
+     * @param Map<arraykey, bool> $memo
+     * @return bool
+     */
+    protected function invokeMemoized(CompiledRule $rule, mixed $value, Map<arraykey, bool> $memo): bool {
+        if (!is_string($value) && !is_int($value)) {
+            return static::invoke($rule, $value);
+        }
+
+        // UNSAFE
+        // Since the value has been refined to an arraykey
+        if ($memo->contains($value)) {
+            return $memo[$value];
+        }
+
+        $passed = static::invoke($rule, $value);
+
+        if ($memo->count() < $this->memoLimit) {
+            $memo[$value] = $passed;
+        }
+
+        return $passed;
+    }
+
+    /**
+     * Return true if the rules of a field are run cheapest first when a bail mode is set.
+     *
+     * @return bool
+     */
+    public function isCostOrdered(): bool {
+        return $this->costOrdering;
+    }
+
+    /**
+     * Return true if cost ordering reports the same rule as the definition order.
+     *
+     * @return bool
+     */
+    public function isCostStrict(): bool {
+        return $this->costStrict;
+    }
+
+    /**
+     * Return true if any rule of a field has failed for a record.
+     *
+     * @param int $index
+     * @param Vector<int> $bits
+     * @param int $base
+     * @return bool
+     */
+    protected function isFieldFailed(int $index, Vector<int> $bits, int $base): bool {
+        for ($bit = $this->offsets[$index], $end = $bit + $this->fields[$index]['rules']->count(); $bit < $end; $bit++) {
+            if (($bits[$base + ($bit >> 6)] & (1 << ($bit & 63))) !== 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Clear every failure bit of a record except the lowest one that was set.
+     *
+     * @param Vector<int> $bits
+     * @param int $base
+     */
+    protected function keepFirstFailure(Vector<int> $bits, int $base): void {
+        $found = false;
+
+        for ($i = $base, $end = $base + $this->words; $i < $end; $i++) {
+            if ($found) {
+                $bits[$i] = 0;
+            } else if ($bits[$i] !== 0) {
+                $word = $bits[$i];
+                $bits[$i] = ($word === PHP_INT_MIN) ? $word : ($word & -$word);
+                $found = true;
+            }
+        }
+    }
+
+    /**
+     * Clear every failure bit of a field except the lowest one that was set.
+     *
+     * @param int $index
+     * @param Vector<int> $bits
+     * @param int $base
+     */
+    protected function keepFirstFieldFailure(int $index, Vector<int> $bits, int $base): void {
+        $found = false;
+        $offset = $this->offsets[$index];
+
+        for ($bit = $offset, $end = $offset + $this->fields[$index]['rules']->count(); $bit < $end; $bit++) {
+            $word = $base + ($bit >> 6);
+            $mask = 1 << ($bit & 63);
+
+            if (($bits[$word] & $mask) === 0) {
+                continue;
+            } else if ($found) {
+                $bits[$word] = $bits[$word] & ~$mask;
+            } else {
+                $found = true;
+            }
+        }
+    }
+
+    /**
+     * Clear the failure bits of every field except the first failed field in the order the data is walked,
+     * which is the order of the record's keys followed by nested paths.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @param Vector<int> $bits
+     * @param int $base
+     */
+    protected function keepFirstWalkedFailure(DataMap $data, Vector<int> $bits, int $base): void {
+        $first = -1;
+
+        foreach ($data as $field => $value) {
+            $index = $this->index->get($field);
+
+            if ($index !== null && $this->isFieldFailed($index, $bits, $base)) {
+                $first = $index;
+                break;
+            }
+        }
+
+        if ($first < 0) {
+            foreach ($this->paths as $index) {
+                if (!$data->contains($this->fields[$index]['field']) && $this->isFieldFailed($index, $bits, $base)) {
+                    $first = $index;
+                    break;
+                }
+            }
+        }
+
+        foreach ($this->fields as $index => $compiled) {
+            if ($index === $first) {
+                continue;
+            }
+
+            for ($bit = $this->offsets[$index], $end = $bit + $compiled['rules']->count(); $bit < $end; $bit++) {
+                $bits[$base + ($bit >> 6)] &= ~(1 << ($bit & 63));
+            }
+        }
+    }
+
+    /**
+     * Return the reason a record should be rejected before any rules are run, or null if it should not.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @return string
+     */
+    public function reject(DataMap $data): ?string {
+        // Reject payloads with too many keys that are not part of the schema
+        if ($this->maxUnknownKeys >= 0 && $this->countUnknownKeys($data) > $this->maxUnknownKeys) {
+            return sprintf('Data contains more than %s unknown fields', $this->maxUnknownKeys);
+        }
+
+        // Reject oversized strings and collections before any constraint reads them,
+        // where only the keys of the schema are inspected, as other keys are never read by its rules
+        if ($this->maxCollectionSize >= 0 && $data->count() > $this->maxCollectionSize) {
+            return sprintf('Data contains a collection of more than %s items', $this->maxCollectionSize);
+        }
+
+        if ($this->maxStringLength >= 0 || $this->maxCollectionSize >= 0 || $this->maxDepth >= 0) {
+            foreach ($this->roots as $root) {
+                $rejection = $data->contains($root) ? $this->inspect($data[$root], 1) : null;
+
+                if ($rejection !== null) {
+                    return $rejection;
+                }
+            }
+        }
+
+        return null;
+    }
+
+    /**
+     * Point the record view back at an empty record once validation is done, so the schema does not keep the last record alive.
+     */
+    public function releaseRecord(): void {
+        if ($this->view !== null) {
+            $this->view->release();
+        }
+    }
+
+    /**
+     * Render the error message for an error code, optionally from a locale's message catalog.
+     *
+     * @param int $code
+     * @param \Titon\Validate\MessageCatalog $catalog
+     * @return string
+     * @throws \Titon\Validate\Exception\MissingMessageException
+     */
+    public function renderCode(int $code, ?MessageCatalog $catalog = null): string {
+        $compiled = $this->fields[$code >> 16];
+
+        if ($this->instrumentation === null) {
+            return $this->formatMessage($compiled, $compiled['rules'][$code & 0xFFFF], $catalog);
+        }
+
+        $start = microtime(true);
+        $message = $this->formatMessage($compiled, $compiled['rules'][$code & 0xFFFF], $catalog);
+
+        $this->instrumentation->recordMessage($this->name, $this->offsets[$code >> 16] + ($code & 0xFFFF), microtime(true) - $start);
+
+        return $message;
+    }
+
+    /**
+     * Render the error message for a field and the index of the rule that failed, optionally from a locale's message catalog.
+     *
+     * @param string $field
+     * @param int $rule
+     * @param \Titon\Validate\MessageCatalog $catalog
+     * @return string
+     */
+    public function renderError(string $field, int $rule, ?MessageCatalog $catalog = null): string {
+        return $this->renderCode(static::packCode($this->index[$field], $rule), $catalog);
+    }
+
+    /**
+     * Return all values of a field within the data. A literal key takes precedence over a nested path.
+     *
+     * @param \Titon\Validate\CompiledField $compiled
+     * @param \Titon\Validate\DataMap $data
+     * @return Vector<mixed>
+     */
+    public function resolve(CompiledField $compiled, DataMap $data): Vector<mixed> {
+        if ($data->contains($compiled['field'])) {
+            return Vector {$data[$compiled['field']]};
+
+        } else if ($compiled['path'] !== null) {
+            return static::walkPath($data, $compiled['path']);
+        }
+
+        return Vector {};
+    }
+
+    /**
+     * Return the rules to run for a value of a field. When the field declares a scalar type and the value is of that type,
+     * the rules with scalar variants of their constraints are returned, so the type is only checked once per value.
+     *
+     * @param int $index
+     * @param mixed $value
+     * @return ImmVector<\Titon\Validate\CompiledRule>
+     */
+    protected function rulesFor(int $index, mixed $value): ImmVector<CompiledRule> {
+        $field = $this->fields[$index];
+        $typed = $field['typed'];
+
+        if ($typed !== null && static::isType($value, $field['type'])) {
+            return $typed;
+        }
+
+        return $field['rules'];
+    }
+
+    /**
+     * Validate the data against the compiled rules and return the result.
+     * The schema itself is never modified, so it's safe to share between requests.
+     * Error messages are not rendered until they are read from the result.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @return \Titon\Validate\ValidationResult
+     */
+    public function validate(DataMap $data): ValidationResult {
+        $bits = $this->allocateBits();
+        $rejection = $this->check($data, $bits);
+
+        return new ValidationResult($this, $bits, 0, $rejection);
+    }
+
+    /**
+     * Validate many records against the compiled rules and return a compact result.
+     * Failures for every record are packed into a single bitset with one bit per rule,
+     * and no error maps are allocated until a record's errors are read.
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return \Titon\Validate\BatchResult
+     */
+    public function validateBatch(Traversable<DataMap> $records): BatchResult {
+        $bits = Vector {};
+        $rejections = Map {};
+        $words = $this->words;
+        $memo = $this->allocateMemo();
+        $count = 0;
+
+        foreach ($records as $data) {
+            $base = $count * $words;
+            $bits->resize($base + $words, 0);
+
+            $rejection = $this->check($data, $bits, $base, $memo);
+
+            if ($rejection !== null) {
+                $rejections[$count] = $rejection;
+            }
+
+            $count++;
+        }
+
+        return new BatchResult($this, $bits, $count, $rejections);
+    }
+
+    /**
+     * Re-validate only the fields affected by the keys of the delta, starting from the failures of a previous
+     * result for the same record. The data is the whole record with the delta already merged in.
+     *
+     * @param \Titon\Validate\ValidationResult $previous
+     * @param \Titon\Validate\DataMap $data
+     * @param \Titon\Validate\DataMap $delta
+     * @return \Titon\Validate\ValidationResult
+     */
+    public function validateChanged(ValidationResult $previous, DataMap $data, DataMap $delta): ValidationResult {
+        return $this->validateFields($previous, $data, $this->getAffectedFields($delta));
+    }
+
+    /**
+     * Validate many records column by column. Each rule is run across every value of its field
+     * before moving on to the next rule, which keeps one constraint and its options hot,
+     * and allows bulk constraints to validate the whole column in a single call.
+     *
+     * The records are materialized up front, and the result is identical to validateBatch().
+     * When not strict, cost ordering runs the rules of each column cheapest first, so the same failure is found first.
+     * When walking the data and bailing on the first failure, every field bails on its own failure, and only
+     * the failure of the field that comes first in the record is kept afterwards.
+     * When bailing, the values of a wildcard field that come after its first failed value are dropped from the column,
+     * and the first failing rule of that value is recorded, as with checkPath().
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return \Titon\Validate\BatchResult
+     */
+    public function validateColumns(Traversable<DataMap> $records): BatchResult {
+        $records = new Vector($records);
+        $count = $records->count();
+        $words = $this->words;
+        $bail = $this->bail;
+        $bits = $this->allocateBits($count);
+        $ordered = ($this->costOrdering && !$this->costStrict && $bail !== BailMode::NONE);
+        $walked = ($this->walk === WalkMode::DATA && $bail === BailMode::ALL);
+        $rejections = Map {};
+        $active = Vector {};
+        $active->resize($count, true);
+        $instrumentation = $this->instrumentation;
+
+        // Which field fails first depends on the key order of each record, so it's resolved afterwards
+        if ($walked) {
+            $bail = BailMode::FIELD;
+        }
+
+        $states = Vector {};
+
+        foreach ($records as $i => $data) {
+            $rejection = $this->reject($data);
+            $states[] = $this->allocateConditions();
+
+            if ($rejection !== null) {
+                $rejections[$i] = $rejection;
+                $active[$i] = false;
+            }
+        }
+
+        foreach ($this->fields as $f => $compiled) {
+            $field = $compiled['field'];
+            $offset = $this->offsets[$f];
+            $rows = Vector {};
+            $values = Vector {};
+
+            // Gather the column, where a wildcard path adds a row per value, in the order the values are walked
+            foreach ($records as $i => $data) {
+                if (!$active[$i] || !$this->applies($f, $data, $states[$i])) {
+                    continue;
+
+                } else if ($data->contains($field)) {
+                    $rows[] = $i;
+                    $values[] = $data[$field];
+
+                } else if ($compiled['path'] !== null) {
+                    foreach (static::walkPath($data, $compiled['path']) as $value) {
+                        $rows[] = $i;
+                        $values[] = $value;
+                    }
+                }
+            }
+
+            // Positions of the remaining rows in the column, the rule each failed row failed first,
+            // and the position of the first failed row of each record
+            $positions = $rows->keys();
+            $firstRule = Map {};
+            $firstRow = Map {};
+
+            foreach (($ordered ? $this->order[$f] : $compiled['rules']->keys()) as $r) {
+                if ($values->isEmpty()) {
+                    break;
+                }
+
+                $rule = $compiled['rules'][$r];
+                $bit = $offset + $r;
+                $word = $bit >> 6;
+                $mask = 1 << ($bit & 63);
+                $start = ($instrumentation !== null) ? microtime(true) : 0.0;
+                $view = $this->view;
+
+                // Cross-field rules are run row by row, with the view pointed at each row's record
+                if ($view === null || $rule['references']->isEmpty()) {
+                    $results = static::invokeColumn($rule, $values, $this->memoLimit);
+                } else {
+                    $results = Vector {};
+
+                    foreach ($values as $k => $value) {
+                        $view->reset($records[$rows[$k]]);
+                        $results[] = static::invoke($rule, $value);
+                    }
+                }
+
+                $failures = 0;
+
+                foreach ($results as $k => $passed) {
+                    if ($passed) {
+                        continue;
+                    }
+
+                    $failures++;
+
+                    // Without bailing, every failure is recorded as is
+                    if ($bail === BailMode::NONE) {
+                        $bits[$rows[$k] * $words + $word] |= $mask;
+                        continue;
+                    }
+
+                    $row = $rows[$k];
+                    $position = $positions[$k];
+                    $firstRule[$position] = $r;
+
+                    if (!$firstRow->contains($row) || $position < $firstRow[$row]) {
+                        $firstRow[$row] = $position;
+                    }
+                }
+
+                if ($instrumentation !== null) {
+                    $instrumentation->recordCalls($this->name, $bit, $values->count(), $failures, microtime(true) - $start);
+                }
+
+                if ($failures === 0 || $bail === BailMode::NONE) {
+                    continue;
+                }
+
+                // Like checkPath(), values after the first failed value of a record are never checked,
+                // while the values before it are still checked against the remaining rules
+                $passedPositions = Vector {};
+                $passedRows = Vector {};
+                $passedValues = Vector {};
+
+                foreach ($rows as $k => $row) {
+                    $position = $positions[$k];
+
+                    if ($firstRow->contains($row) && $position >= $firstRow[$row]) {
+                        continue;
+                    }
+
+                    $passedPositions[] = $position;
+                    $passedRows[] = $row;
+                    $passedValues[] = $values[$k];
+                }
+
+                $positions = $passedPositions;
+                $rows = $passedRows;
+                $values = $passedValues;
+            }
+
+            // Record the first failing rule of the first failed value, and remove the records from all later fields when bailing entirely
+            foreach ($firstRow as $row => $position) {
+                $bit = $offset + $firstRule[$position];
+                $bits[$row * $words + ($bit >> 6)] |= (1 << ($bit & 63));
+
+                if ($bail === BailMode::ALL) {
+                    $active[$row] = false;
+                }
+            }
+        }
+
+        if ($walked) {
+            foreach ($records as $i => $data) {
+                if ($active[$i]) {
+                    $this->keepFirstWalkedFailure($data, $bits, $i * $words);
+                }
+            }
+        }
+
+        $this->releaseRecord();
+
+        return new BatchResult($this, $bits, $count, $rejections);
+    }
+
+    /**
+     * Re-validate the fields at the defined indices, starting from the failures of a previous result for the same record.
+     * Failures of all other fields are copied from the previous result, so the cost scales with the number of fields.
+     * The whole data is validated when the previous result belongs to another schema or was rejected,
+     * or when bailing on the first failure, since that failure may belong to a field that was not re-validated.
+     *
+     * @param \Titon\Validate\ValidationResult $previous
+     * @param \Titon\Validate\DataMap $data
+     * @param Traversable<int> $fields
+     * @return \Titon\Validate\ValidationResult
+     */
+    public function validateFields(ValidationResult $previous, DataMap $data, Traversable<int> $fields): ValidationResult {
+        if ($previous->getSchema() !== $this || $previous->rejected() || $this->bail === BailMode::ALL) {
+            return $this->validate($data);
+        }
+
+        $rejection = $this->reject($data);
+
+        if ($rejection !== null) {
+            return new ValidationResult($this, $this->allocateBits(), 0, $rejection);
+        }
+
+        $this->bindRecord($data);
+
+        $bits = $previous->getWords();
+        $timed = ($this->instrumentation !== null && $this->instrumentation->sample());
+        $state = $this->allocateConditions();
+
+        foreach ($fields as $index) {
+            $compiled = $this->fields[$index];
+
+            // Clear the previous failures of the field
+            for ($bit = $this->offsets[$index], $end = $bit + $compiled['rules']->count(); $bit < $end; $bit++) {
+                $bits[$bit >> 6] &= ~(1 << ($bit & 63));
+            }
+
+            if (!$this->applies($index, $data, $state)) {
+                continue;
+
+            } else if ($data->contains($compiled['field'])) {
+                $this->checkField($index, $data[$compiled['field']], $bits, 0, null, $timed);
+
+            } else if ($compiled['path'] !== null) {
+                $this->checkPath($index, $data, $bits, 0, null, $timed);
+            }
+        }
+
+        $this->releaseRecord();
+
+        return new ValidationResult($this, $bits);
+    }
+
+    /**
+     * Validate records one at a time as they are read from a stream or generator, and yield a result for each.
+     * Only the current record is held in memory, so the input can be of any size.
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return Iterator<\Titon\Validate\ValidationResult>
+     */
+    public function validateStream(Traversable<DataMap> $records): Iterator<ValidationResult> {
+        foreach ($records as $data) {
+            yield $this->validate($data);
+        }
+    }
+
+    /**
+     * Return a copy of the schema that uses the defined bail mode.
+     * With a bail mode, the first failing rule of a field is reported instead of the last.
+     *
+     * @param \Titon\Validate\BailMode $mode
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function withBailMode(BailMode $mode): CompiledSchema {
+        $schema = clone $this;
+        $schema->bail = $mode;
+
+        return $schema;
+    }
+
+    /**
+     * Return a copy of the schema that runs the rules of a field cheapest first when a bail mode is set.
+     *
+     * When strict, the reported rule is the same as with the definition order. This requires every rule defined
+     * before the reported one to run, so it never runs fewer rules than the definition order does, and only
+     * moves cheap rules ahead of expensive ones. When not strict, the first failure found in cost order is reported,
+     * which skips expensive rules once a cheap one fails, but may report a different rule of the field.
+     *
+     * @param bool $ordering
+     * @param bool $strict
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function withCostOrdering(bool $ordering = true, bool $strict = true): CompiledSchema {
+        $schema = clone $this;
+        $schema->costOrdering = $ordering;
+        $schema->costStrict = $strict;
+
+        return $schema;
+    }
+
+    /**
+     * Return a copy of the schema that caches async constraint results. The cache can be shared between schemas.
+     *
+     * @param \Titon\Validate\ConstraintCache $cache
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function withCache(?ConstraintCache $cache): CompiledSchema {
+        $schema = clone $this;
+        $schema->cache = $cache;
+
+        return $schema;
+    }
+
+    /**
+     * Return a copy of the schema that reports timing and failure counters to a collector under the defined name.
+     * Passing null disables instrumentation, which leaves a single check per record on the hot path.
+     *
+     * @param \Titon\Validate\Instrumentation $instrumentation
+     * @param string $name
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function withInstrumentation(?Instrumentation $instrumentation, string $name = ''): CompiledSchema {
+        $schema = clone $this;
+        $schema->instrumentation = $instrumentation;
+        $schema->name = $name;
+
+        if ($instrumentation !== null) {
+            $instrumentation->register($name, $schema);
+        }
+
+        return $schema;
+    }
+
+    /**
+     * Return a copy of the schema that rejects data when the record, or any collection nested within the schema's fields,
+     * contains more items than the defined limit. A negative limit disables the check.
+     *
+     * @param int $max
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function withMaxCollectionSize(int $max): CompiledSchema {
+        $schema = clone $this;
+        $schema->maxCollectionSize = $max;
+
+        return $schema;
+    }
+
+    /**
+     * Return a copy of the schema that rejects data with collections nested deeper than the defined limit,
+     * where values of the record are at a depth of 1. A negative limit disables the check.
+     *
+     * @param int $max
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function withMaxDepth(int $max): CompiledSchema {
+        $schema = clone $this;
+        $schema->maxDepth = $max;
+
+        return $schema;
+    }
+
+    /**
+     * Return a copy of the schema that rejects data when a field of the schema contains a string longer than the defined
+     * number of bytes, so that expensive constraints such as patterns never run over oversized input. A negative limit disables the check.
+     *
+     * @param int $max
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function withMaxStringLength(int $max): CompiledSchema {
+        $schema = clone $this;
+        $schema->maxStringLength = $max;
+
+        return $schema;
+    }
+
+    /**
+     * Return a copy of the schema that rejects data containing more unknown keys than the defined limit.
+     * A negative limit disables the check.
+     *
+     * @param int $max
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function withMaxUnknownKeys(int $max): CompiledSchema {
+        $schema = clone $this;
+        $schema->maxUnknownKeys = $max;
+
+        return $schema;
+    }
+
+    /**
+     * Return a copy of the schema that memoizes up to the defined number of results per pure rule during a batch.
+     * Zero disables memoization.
+     *
+     * @param int $limit
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function withMemoLimit(int $limit): CompiledSchema {
+        $schema = clone $this;
+        $schema->memoLimit = $limit;
+
+        return $schema;
+    }
+
+    /**
+     * Return a copy of the schema that iterates either the compiled fields or the data during validation.
+     *
+     * @param \Titon\Validate\WalkMode $mode
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function withWalkMode(WalkMode $mode): CompiledSchema {
+        $schema = clone $this;
+        $schema->walk = $mode;
+
+        return $schema;
+    }
+
+    /**
+     * Return a copy of the rules with the record view bound as the first argument of every cross-field rule.
+     * A view that was bound before is replaced.
+     *
+     * @param ImmVector<\Titon\Validate\CompiledRule> $rules
+     * @param \Titon\Validate\RecordView $view
+     * @return ImmVector<\Titon\Validate\CompiledRule>
+     */
+    public static function bindView(ImmVector<CompiledRule> $rules, RecordView $view): ImmVector<CompiledRule> {
+        return $rules->map($rule ==> {
+            if ($rule['references']->isEmpty()) {
+                return $rule;
+            }
+
+            $arguments = $rule['arguments'];
+
+            if ($arguments && $arguments[0] instanceof RecordView) {
+                $arguments[0] = $view;
+            } else {
+                array_unshift($arguments, $view);
+            }
+
+            $rule['arguments'] = $arguments;
+            $rule['arity'] = count($arguments);
+
+            return $rule;
+        });
+    }
+
+    /**
+     * Wrap an async constraint so that it can be executed synchronously by blocking on its result.
+     * The options are bound up front, so any options passed to the wrapper are ignored.
+     *
+     * @param \Titon\Validate\AsyncConstraintCallback $callback
+     * @param array<mixed> $args
+     * @return \Titon\Validate\ConstraintCallback
+     */
+    public static function blockOn(AsyncConstraintCallback $callback, array<mixed> $args): ConstraintCallback {
+        return (mixed $value) ==> static::invokeAsync($callback, $args, $value)->getWaitHandle()->join();
+    }
+
+    /**
+     * Return a bulk constraint that matches a column of values against a compiled pattern in a single call.
+     *
+     * @param string $pattern
+     * @return \Titon\Validate\BulkConstraintCallback
+     */
+    public static function bulkMatcher(string $pattern): BulkConstraintCallback {
+        return (Vector<mixed> $values) ==> {
+            $strings = Map {};
+
+            foreach ($values as $i => $value) {
+                if (is_scalar($value)) {
+                    $strings[$i] = (string) $value;
+                }
+            }
+
+            $matches = preg_grep($pattern, $strings->toArray());
+
+            return $values->mapWithKey(($i, $value) ==> array_key_exists($i, $matches));
+        };
+    }
+
+    /**
+     * Compile a map of conditions into a list, where each parent is referenced by its index.
+     *
+     * @param \Titon\Validate\ConditionMap $conditions
+     * @return \Titon\Validate\CompiledConditionList
+     * @throws \InvalidArgumentException
+     */
+    public static function compileConditions(ConditionMap $conditions): CompiledConditionList {
+        $index = Map {};
+        $compiled = Vector {};
+
+        foreach ($conditions->keys() as $i => $name) {
+            $index[$name] = $i;
+        }
+
+        foreach ($conditions as $name => $condition) {
+            $compiled[] = shape(
+                'name' => $name,
+                'predicate' => $condition['predicate'],
+                'parent' => static::resolveCondition($index, $condition['parent']),
+                'keys' => $condition['keys']->toImmVector()
+            );
+        }
+
+        return $compiled->toImmVector();
+    }
+
+    /**
+     * Validate a regex pattern for a rule and return it.
+     *
+     * @param string $rule
+     * @param string $pattern
+     * @return string
+     * @throws \Titon\Validate\Exception\InvalidPatternException
+     */
+    public static function compilePattern(string $rule, string $pattern): string {
+        if ($pattern === '' || @preg_match($pattern, '') === false) {
+            throw new InvalidPatternException(sprintf('Invalid pattern %s for rule %s', $pattern, $rule));
+        }
+
+        return $pattern;
+    }
+
+    /**
+     * Return a cross-field constraint as a constraint callback. It is called with the record view
+     * as the first argument once the schema has bound it.
+     *
+     * @param \Titon\Validate\CrossConstraint $cross
+     * @return \Titon\Validate\ConstraintCallback
+     */
+    public static function crossCallback(CrossConstraint $cross): ConstraintCallback {
+        // UNSAFE
+        // Since the callback also receives the record view and options
+        return $cross['callback'];
+    }
+
+    /**
+     * Return the names of the fields referenced by a cross-field rule, which are its leading options.
+     *
+     * @param \Titon\Validate\CrossConstraint $cross
+     * @param array<mixed> $arguments
+     * @return ImmVector<string>
+     */
+    public static function crossReferences(CrossConstraint $cross, array<mixed> $arguments): ImmVector<string> {
+        return (new ImmVector(array_slice($arguments, 0, $cross['references'])))->map($field ==> (string) $field);
+    }
+
+    /**
+     * Wrap an async bulk constraint so that it can validate a single value.
+     * The options are bound up front, so any options passed to the wrapper are ignored.
+     *
+     * @param \Titon\Validate\AsyncBulkConstraintCallback $callback
+     * @param array<mixed> $args
+     * @return \Titon\Validate\AsyncConstraintCallback
+     */
+    public static function firstOf(AsyncBulkConstraintCallback $callback, array<mixed> $args): AsyncConstraintCallback {
+        return (mixed $value) ==> static::genFirst($callback, $args, $value);
+    }
+
+    /**
+     * Rebuild a schema from an export, binding constraints by rule name from the validator.
+     * Options are not parsed and messages are not tokenized again.
+     *
+     * @param array<string, mixed> $export
+     * @param \Titon\Validate\Validator $validator
+     * @return \Titon\Validate\CompiledSchema
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public static function fromExport(array<string, mixed> $export, Validator $validator): CompiledSchema {
+        // UNSAFE
+        // Since the export is a list of plain values
+        $constraints = $validator->getConstraints();
+        $asyncConstraints = $validator->getAsyncConstraints();
+        $asyncBulkConstraints = $validator->getAsyncBulkConstraints();
+        $bulkConstraints = $validator->getBulkConstraints();
+        $crossConstraints = $validator->getCrossConstraints();
+        $optionTypes = $validator->getOptionTypes();
+        $typedConstraints = $validator->getTypedConstraints();
+        $scalarConstraints = $validator->getScalarConstraints();
+        $conditions = static::compileConditions($validator->getConditions());
+        $conditionIndex = Map {};
+        $fields = Vector {};
+
+        foreach ($conditions as $i => $condition) {
+            $conditionIndex[$condition['name']] = $i;
+        }
+
+        foreach ($export['fields'] as $field) {
+            $rules = Vector {};
+
+            foreach ($field[2] as $item) {
+                list($rule, $key, $message, $options, $arguments, $pure, $cost, $pattern, $template, $tokens) = $item;
+
+                $async = $asyncConstraints->get($rule);
+                $asyncBulk = $asyncBulkConstraints->get($rule);
+
+                if ($async === null && $asyncBulk !== null) {
+                    $async = static::firstOf($asyncBulk, $arguments);
+                }
+
+                $cross = ($async === null) ? $crossConstraints->get($rule) : null;
+
+                if ($async === null && $cross === null && !$constraints->contains($rule)) {
+                    throw new MissingConstraintException(sprintf('Validation constraint %s does not exist', $rule));
+                }
+
+                $references = ImmVector {};
+                $constraint = ($async !== null) ? static::blockOn($async, $arguments) : (($cross !== null) ? static::crossCallback($cross) : $constraints[$rule]);
+                $bulk = ($async !== null) ? null : $bulkConstraints->get($rule);
+
+                if ($cross !== null) {
+                    $references = static::crossReferences($cross, $arguments);
+                    $bulk = null;
+
+                } else if ($async === null && $pattern !== null) {
+                    $constraint = static::matcher($pattern);
+                    $bulk = static::bulkMatcher($pattern);
+
+                } else if ($async === null && $optionTypes->contains($rule) && $typedConstraints->contains($rule)) {
+                    $constraint = $typedConstraints[$rule];
+                    $bulk = null;
+                }
+
+                $rules[] = shape(
+                    'rule' => $rule,
+                    'key' => $key,
+                    'message' => $message,
+                    'options' => new ImmVector($options),
+                    'arguments' => $arguments,
+                    'arity' => count($arguments),
+                    'pure' => ($async === null && $cross === null && $pure),
+                    'cost' => (float) $cost,
+                    'references' => $references,
+                    'pattern' => $pattern,
+                    'constraint' => $constraint,
+                    'bulk' => $bulk,
+                    'async' => $async,
+                    'asyncBulk' => $asyncBulk,
+                    'template' => $template,
+                    'tokens' => new ImmMap($tokens)
+                );
+            }
+
+            $rules = $rules->toImmVector();
+
+            $fields[] = shape(
+                'field' => $field[0],
+                'title' => $field[1],
+                'path' => static::splitPath($field[0]),
+                'condition' => static::resolveCondition($conditionIndex, (string) $field[3]),
+                'type' => $field[4],
+                'rules' => $rules,
+                'typed' => static::specialize($rules, $field[4], $scalarConstraints)
+            );
+        }
+
+        return (new CompiledSchema($fields->toImmVector(), $conditions))
+            ->withBailMode($export['bail'])
+            ->withWalkMode($export['walk'])
+            ->withCostOrdering($export['costOrdering'], $export['costStrict'])
+            ->withMaxUnknownKeys($export['maxUnknownKeys'])
+            ->withMaxCollectionSize($export['maxCollectionSize'])
+            ->withMaxDepth($export['maxDepth'])
+            ->withMaxStringLength($export['maxStringLength'])
+            ->withMemoLimit($export['memoLimit']);
+    }
+
+    /**
+     * Freeze the current state of a validator into a compiled schema.
+     * All constraints must exist at compile time, so missing constraints are reported immediately.
+     *
+     * @param \Titon\Validate\Validator $validator
+     * @return \Titon\Validate\CompiledSchema
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     * @throws \InvalidArgumentException
+     */
+    public static function fromValidator(Validator $validator): CompiledSchema {
+        $constraints = $validator->getConstraints();
+        $asyncConstraints = $validator->getAsyncConstraints();
+        $asyncBulkConstraints = $validator->getAsyncBulkConstraints();
+        $bulkConstraints = $validator->getBulkConstraints();
+        $crossConstraints = $validator->getCrossConstraints();
+        $pureConstraints = $validator->getPureConstraints();
+        $costs = $validator->getConstraintCosts();
+        $patternConstraints = $validator->getPatternConstraints();
+        $optionTypes = $validator->getOptionTypes();
+        $typedConstraints = $validator->getTypedConstraints();
+        $scalarConstraints = $validator->getScalarConstraints();
+        $fieldTypes = $validator->getFieldTypes();
+        $messages = $validator->getMessages();
+        $fieldRules = $validator->getRules();
+        $fieldConditions = $validator->getFieldConditions();
+        $conditions = static::compileConditions($validator->getConditions());
+        $conditionIndex = Map {};
+        $fields = Vector {};
+
+        foreach ($conditions as $i => $condition) {
+            $conditionIndex[$condition['name']] = $i;
+        }
+
+        foreach ($validator->getFields() as $field => $title) {
+            $rules = Vector {};
+
+            if ($fieldRules->contains($field)) {
+                foreach ($fieldRules[$field] as $rule => $params) {
+                    $async = $asyncConstraints->get($rule);
+                    $asyncBulk = $asyncBulkConstraints->get($rule);
+                    $arguments = $params['options']->toArray();
+
+                    // Derive a single value version from the bulk version
+                    if ($async === null && $asyncBulk !== null) {
+                        $async = static::firstOf($asyncBulk, $arguments);
+                    }
+
+                    $cross = ($async === null) ? $crossConstraints->get($rule) : null;
+
+                    if ($async === null && $cross === null && !$constraints->contains($rule)) {
+                        throw new MissingConstraintException(sprintf('Validation constraint %s does not exist', $rule));
+                    }
+
+                    $message = $params['message'] ?: (string) $messages->get($rule);
+                    $tokens = Map {
+                        'field' => $field,
+                        'title' => $title
+                    };
+
+                    foreach ($params['options'] as $i => $option) {
+                        $tokens[(string) $i] = ($option instanceof Indexish) ? implode(', ', $option) : (string) $option;
+                    }
+
+                    $key = $rule . ':' . md5(serialize($arguments));
+                    $pattern = null;
+                    $references = ImmVector {};
+                    $constraint = ($async !== null) ? static::blockOn($async, $arguments) : (($cross !== null) ? static::crossCallback($cross) : $constraints[$rule]);
+                    $bulk = ($async !== null) ? null : $bulkConstraints->get($rule);
+
+                    // Cross-field constraints are bound to the record view when the schema is built
+                    if ($cross !== null) {
+                        $references = static::crossReferences($cross, $arguments);
+                        $bulk = null;
+
+                    // Validate the pattern once and bind it to a matcher, so that options are no longer passed
+                    } else if ($async === null && $patternConstraints->contains($rule)) {
+                        $pattern = static::compilePattern($rule, (string) idx($arguments, $patternConstraints[$rule], ''));
+                        $constraint = static::matcher($pattern);
+                        $bulk = static::bulkMatcher($pattern);
+                        $arguments = [];
+
+                    // Parse options once, and prefer a typed variant that accepts the parsed options
+                    } else if ($async === null && $optionTypes->contains($rule)) {
+                        $arguments = static::parseOptions($rule, $arguments, $optionTypes[$rule]);
+
+                        if ($typedConstraints->contains($rule)) {
+                            $constraint = $typedConstraints[$rule];
+                            $bulk = null;
+                        }
+                    }
+
+                    $rules[] = shape(
+                        'rule' => $rule,
+                        'key' => $key,
+                        'message' => $message,
+                        'options' => $params['options']->toImmVector(),
+                        'arguments' => $arguments,
+                        'arity' => count($arguments),
+                        'pure' => ($async === null && $cross === null && $pureConstraints->contains($rule)),
+                        'cost' => $costs->contains($rule) ? $costs[$rule] : 1.0,
+                        'references' => $references,
+                        'pattern' => $pattern,
+                        'constraint' => $constraint,
+                        'bulk' => $bulk,
+                        'async' => $async,
+                        'asyncBulk' => $asyncBulk,
+                        'template' => new MessageTemplate($message),
+                        'tokens' => $tokens->toImmMap()
+                    );
+                }
+            }
+
+            $type = $fieldTypes->contains($field) ? $fieldTypes[$field] : FieldType::MIXED;
+            $rules = $rules->toImmVector();
+
+            $fields[] = shape(
+                'field' => $field,
+                'title' => $title,
+                'path' => static::splitPath($field),
+                'condition' => static::resolveCondition($conditionIndex, (string) $fieldConditions->get($field)),
+                'type' => $type,
+                'rules' => $rules,
+                'typed' => static::specialize($rules, $type, $scalarConstraints)
+            );
+        }
+
+        return new CompiledSchema($fields->toImmVector(), $conditions);
+    }
+
+    /**
+     * Resolve a single value through an async bulk constraint.
+     *
+     * @param \Titon\Validate\AsyncBulkConstraintCallback $callback
+     * @param array<mixed> $args
+     * @param mixed $value
+     * @return Awaitable<bool>
+     */
+    protected static async function genFirst(AsyncBulkConstraintCallback $callback, array<mixed> $args, mixed $value): Awaitable<bool> {
+        $results = await static::invokeAsyncBulk($callback, $args, Vector {$value});
+
+        return (bool) $results[0];
+    }
+
+    /**
+     * Return a constraint that matches a value against a compiled pattern. Any options passed are ignored.
+     *
+     * @param string $pattern
+     * @return \Titon\Validate\ConstraintCallback
+     */
+    public static function matcher(string $pattern): ConstraintCallback {
+        return (mixed $value) ==> (is_scalar($value) && preg_match($pattern, (string) $value) === 1);
+    }
+
+    /**
+     * Execute an async constraint against a value, dispatching the common arities as direct calls.
+     *
+     * @param \Titon\Validate\AsyncConstraintCallback $callback
+     * @param array<mixed> $args
+     * @param mixed $value
+     * @return Awaitable<bool>
+     */
+    public static function invokeAsync(AsyncConstraintCallback $callback, array<mixed> $args, mixed $value): Awaitable<bool> {
+        // UNSAFE
+        // Since constraints accept a variable number of options
+        switch (count($args)) {
+            case 0:
+                return $callback($value);
+            case 1:
+                return $callback($value, $args[0]);
+            case 2:
+                return $callback($value, $args[0], $args[1]);
+            case 3:
+                return $callback($value, $args[0], $args[1], $args[2]);
+            default:
+                array_unshift($args, $value);
+
+                return call_user_func_array($callback, $args);
+        }
+    }
+
+    /**
+     * Execute an async bulk constraint against a list of values, dispatching the common arities as direct calls.
+     *
+     * @param \Titon\Validate\AsyncBulkConstraintCallback $callback
+     * @param array<mixed> $args
+     * @param Vector<mixed> $values
+     * @return Awaitable<Vector<bool>>
+     */
+    public static function invokeAsyncBulk(AsyncBulkConstraintCallback $callback, array<mixed> $args, Vector<mixed> $values): Awaitable<Vector<bool>> {
+        // UNSAFE
+        // Since constraints accept a variable number of options
+        switch (count($args)) {
+            case 0:
+                return $callback($values);
+            case 1:
+                return $callback($values, $args[0]);
+            case 2:
+                return $callback($values, $args[0], $args[1]);
+            case 3:
+                return $callback($values, $args[0], $args[1], $args[2]);
+            default:
+                array_unshift($args, $values);
+
+                return call_user_func_array($callback, $args);
+        }
+    }
+
+    /**
+     * Execute a rule's constraint against a column of values and return a list of results.
+     * The bulk variant of the constraint is used when available, otherwise results of pure rules
+     * are memoized for repeated string and integer values, up to the defined limit.
+     *
+     * @param \Titon\Validate\CompiledRule $rule
+     * @param Vector<mixed> $values
+     * @param int $memoLimit
+     * @return Vector<bool>
+     */
+    public static function invokeColumn(CompiledRule $rule, Vector<mixed> $values, int $memoLimit = 0): Vector<bool> {
+        $bulk = $rule['bulk'];
+
+        if ($bulk === null) {
+            $results = Vector {};
+            $memo = Map {};
+            $memoize = ($rule['pure'] && $memoLimit > 0);
+
+            foreach ($values as $value) {
+                if (!$memoize || (!is_string($value) && !is_int($value))) {
+                    $results[] = static::invoke($rule, $value);
+                    continue;
+                }
+
+                // UNSAFE
+                // Since the value has been refined to an arraykey
+                if (!$memo->contains($value)) {
+                    $passed = static::invoke($rule, $value);
+
+                    if ($memo->count() >= $memoLimit) {
+                        $results[] = $passed;
+                        continue;
+                    }
+
+                    $memo[$value] = $passed;
+                }
+
+                $results[] = $memo[$value];
+            }
+
+            return $results;
+        }
+
+        $args = $rule['arguments'];
+
+        // UNSAFE
+        // Since bulk constraints accept a variable number of options
+        switch ($rule['arity']) {
+            case 0:
+                return $bulk($values);
+            case 1:
+                return $bulk($values, $args[0]);
+            case 2:
+                return $bulk($values, $args[0], $args[1]);
+            case 3:
+                return $bulk($values, $args[0], $args[1], $args[2]);
+            default:
+                array_unshift($args, $values);
+
+                return call_user_func_array($bulk, $args);
+        }
+    }
+
+    /**
+     * Return true if a value is of a field type. Every value is of the mixed type.
+     *
+     * @param mixed $value
+     * @param \Titon\Validate\FieldType $type
+     * @return bool
+     */
+    public static function isType(mixed $value, FieldType $type): bool {
+        switch ($type) {
+            case FieldType::STRING:
+                return is_string($value);
+            case FieldType::INT:
+                return is_int($value);
+            case FieldType::FLOAT:
+                return is_float($value);
+            case FieldType::BOOL:
+                return is_bool($value);
+            default:
+                return true;
+        }
+    }
+
+    /**
+     * Pack a field index and rule index into a single error code.
+     * The field index occupies the high bits and the rule index the low 16 bits,
+     * which is why a schema can not be compiled with more than 65536 rules for a field.
+     *
+     * @param int $field
+     * @param int $rule
+     * @return int
+     */
+    public static function packCode(int $field, int $rule): int {
+        return ($field << 16) | $rule;
+    }
+
+    /**
+     * Parse a rule's options into their declared types. A list or set that is not already a collection
+     * is built from the remaining options, which is how shorthand rules like "inList:a,b,c" arrive.
+     * Options without a declared type are passed through as is.
+     *
+     * @param string $rule
+     * @param array<mixed> $args
+     * @param Vector<\Titon\Validate\OptionType> $types
+     * @return array<mixed>
+     * @throws \InvalidArgumentException
+     */
+    public static function parseOptions(string $rule, array<mixed> $args, Vector<OptionType> $types): array<mixed> {
+        $parsed = [];
+
+        foreach ($args as $i => $arg) {
+            $type = $types->get($i);
+
+            if ($type === OptionType::LIST || $type === OptionType::SET) {
+                $list = ($arg instanceof Traversable) ? new ImmVector($arg) : new ImmVector(array_slice($args, $i));
+
+                if ($type === OptionType::SET) {
+                    $parsed[] = $list->filter($item ==> is_scalar($item))->map($item ==> (string) $item)->toImmSet();
+                } else {
+                    $parsed[] = $list;
+                }
+
+                if (!($arg instanceof Traversable)) {
+                    break;
+                }
+
+                continue;
+            }
+
+            switch ($type) {
+                case OptionType::STRING:
+                    $arg = (string) $arg;
+                    break;
+                case OptionType::INT:
+                case OptionType::FLOAT:
+                    if (!is_numeric($arg)) {
+                        throw new InvalidArgumentException(sprintf('Option %s for rule %s must be numeric', $i, $rule));
+                    }
+
+                    $arg = ($type === OptionType::INT) ? (int) $arg : (float) $arg;
+                    break;
+                case OptionType::BOOL:
+                    $bool = filter_var($arg, FILTER_VALIDATE_BOOLEAN, FILTER_NULL_ON_FAILURE);
+
+                    if ($bool === null) {
+                        throw new InvalidArgumentException(sprintf('Option %s for rule %s must be a boolean', $i, $rule));
+                    }
+
+                    $arg = $bool;
+                    break;
+            }
+
+            $parsed[] = $arg;
+        }
+
+        return $parsed;
+    }
+
+    /**
+     * Return the index of a named condition, or -1 if no name is defined.
+     *
+     * @param Map<string, int> $index
+     * @param string $name
+     * @return int
+     * @throws \InvalidArgumentException
+     */
+    public static function resolveCondition(Map<string, int> $index, string $name): int {
+        if ($name === '') {
+            return -1;
+        }
+
+        if (!$index->contains($name)) {
+            throw new InvalidArgumentException(sprintf('Condition %s does not exist', $name));
+        }
+
+        return $index[$name];
+    }
+
+    /**
+     * Return a copy of the rules with each constraint replaced by its scalar variant for the field type,
+     * or null if the field has no type or none of its constraints have a variant.
+     * Rules bound to a pattern or an async constraint keep their constraint.
+     *
+     * @param ImmVector<\Titon\Validate\CompiledRule> $rules
+     * @param \Titon\Validate\FieldType $type
+     * @param \Titon\Validate\ScalarConstraintMap $variants
+     * @return ImmVector<\Titon\Validate\CompiledRule>
+     */
+    public static function specialize(ImmVector<CompiledRule> $rules, FieldType $type, ScalarConstraintMap $variants): ?ImmVector<CompiledRule> {
+        if ($type === FieldType::MIXED) {
+            return null;
+        }
+
+        $typed = Vector {};
+        $replaced = false;
+
+        foreach ($rules as $rule) {
+            $name = $rule['rule'];
+
+            if ($rule['pattern'] === null && $rule['async'] === null && $variants->contains($name) && $variants[$name]->contains($type)) {
+                $rule['constraint'] = $variants[$name][$type];
+                $replaced = true;
+            }
+
+            $typed[] = $rule;
+        }
+
+        return $replaced ? $typed->toImmVector() : null;
+    }
+
+    /**
+     * Split a field name into the segments of a nested path, or return null if the name is not a path.
+     * A "*" segment matches every child of a collection.
+     *
+     * @param string $field
+     * @return ImmVector<string>
+     */
+    public static function splitPath(string $field): ?ImmVector<string> {
+        if (strpos($field, '.') === false) {
+            return null;
+        }
+
+        return new ImmVector(explode('.', $field));
+    }
+
+    /**
+     * Unpack an error code into a field index and rule index.
+     *
+     * @param int $code
+     * @return Pair<int, int>
+     */
+    public static function unpackCode(int $code): Pair<int, int> {
+        return Pair {$code >> 16, $code & 0xFFFF};
+    }
+
+    /**
+     * Walk a nested path through maps, vectors and arrays in place, and return the values it resolves to.
+     * Only the referenced subtrees are visited, and missing segments resolve to no values.
+     *
+     * @param mixed $data
+     * @param ImmVector<string> $path
+     * @return Vector<mixed>
+     */
+    public static function walkPath(mixed $data, ImmVector<string> $path): Vector<mixed> {
+        $values = Vector {$data};
+
+        foreach ($path as $segment) {
+            $next = Vector {};
+
+            foreach ($values as $value) {
+                if ($segment === '*') {
+                    if ($value instanceof Traversable || is_array($value)) {
+                        foreach ($value as $child) {
+                            $next[] = $child;
+                        }
+                    }
+
+                } else if ($value instanceof Vector || $value instanceof ImmVector) {
+                    if (ctype_digit($segment) && $value->containsKey((int) $segment)) {
+                        $next[] = $value[(int) $segment];
+                    }
+
+                } else if ($value instanceof Map || $value instanceof ImmMap) {
+                    if ($value->containsKey($segment)) {
+                        $next[] = $value[$segment];
+                    }
+
+                } else if (is_array($value) && array_key_exists($segment, $value)) {
+                    $next[] = $value[$segment];
+                }
+            }
+
+            if ($next->isEmpty()) {
+                return $next;
+            }
+
+            $values = $next;
+        }
+
+        return $values;
+    }
+
+}
@@ -11,25 +11,229 @@ use Titon\Utility\Validate;
 
 /**
  * Default provider of constraints, which are inherited from the utility Validate class.
+ * Every map and its closures are built once per class and shared through the constraint registry.
  *
  * @package Titon\Validate
  */
-class Constraint extends Validate implements ConstraintProvider {
+class Constraint extends Validate implements ConstraintProvider, BulkConstraintProvider, CostConstraintProvider, CrossConstraintProvider, PatternConstraintProvider, PureConstraintProvider, ScalarConstraintProvider, TypedConstraintProvider {
 
     /**
      * {@inheritdoc}
+     *
+     * Bulk variants apply the same checks as their single value counterparts,
+     * but share one set of bounds across the whole column. Patterns are matched in bulk by the compiled schema.
+     */
+    public function getBulkConstraints(): BulkConstraintMap {
+        return ConstraintRegistry::loadBulk(static::class, () ==> {
+            // UNSAFE
+            // Since the callbacks accept options beyond the list of values
+            return Map {
+                'inRange' => (Vector<mixed> $values, mixed $min, mixed $max) ==> {
+                    return $values->map($value ==> ($value <= $max && $value >= $min));
+                }
+            };
+        });
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * Comparisons are cheapest, followed by regex based checks, while `email` may resolve DNS records.
+     * Constraints that are not listed default to a cost of 1.
+     */
+    public function getConstraintCosts(): Map<string, float> {
+        return ConstraintRegistry::loadMap(static::class, 'costs', () ==> {
+            return Map {
+                'notEmpty' => 0.2, 'boolean' => 0.3, 'numeric' => 0.3, 'equal' => 0.3, 'exact' => 0.5,
+                'between' => 0.5, 'inList' => 0.5, 'inRange' => 0.5, 'maxLength' => 0.5, 'minLength' => 0.5, 'comparison' => 0.5,
+                'alpha' => 2.0, 'alphaNumeric' => 2.0, 'currency' => 2.0, 'custom' => 2.0, 'date' => 2.0, 'decimal' => 2.0,
+                'ip' => 2.0, 'phone' => 2.0, 'postalCode' => 2.0, 'ssn' => 2.0, 'time' => 2.0, 'uuid' => 2.0,
+                'luhn' => 3.0, 'url' => 3.0, 'creditCard' => 5.0, 'email' => 1000.0,
+                'match' => 0.5, 'sumOf' => 2.0, 'dateAfter' => 3.0, 'dateBefore' => 3.0
+            };
+        });
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * Methods are only reflected the first time a class is used,
+     * afterwards the map is shared through the constraint registry.
      */
     public function getConstraints(): ConstraintMap {
-        $constraints = Map {};
         $class = static::class;
 
-        foreach (get_class_methods($this) as $method) {
+        return ConstraintRegistry::load($class, () ==> {
+            $constraints = Map {};
+
+            foreach (get_class_methods($class) as $method) {
+                // UNSAFE
+                // Since `class_meth()` requires literal strings and we are passing variables
+                $constraints[$method] = class_meth($class, $method);
+            }
+
+            return $constraints;
+        });
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * Date comparisons pass when the referenced field has no valid date, so that the failure is reported by its own rules.
+     */
+    public function getCrossConstraints(): CrossConstraintMap {
+        return ConstraintRegistry::loadMap(static::class, 'crossConstraints', () ==> {
+            $compare = (mixed $input, mixed $other, bool $after) ==> {
+                $time = is_scalar($input) ? strtotime((string) $input) : false;
+                $otherTime = is_scalar($other) ? strtotime((string) $other) : false;
+
+                if ($otherTime === false) {
+                    return true;
+                }
+
+                return ($time !== false && ($after ? $time > $otherTime : $time < $otherTime));
+            };
+
+            // UNSAFE
+            // Since the callbacks accept the referenced field names as options
+            return Map {
+                'dateAfter' => shape(
+                    'callback' => (mixed $input, RecordView $record, string $field) ==> $compare($input, $record->get($field), true),
+                    'references' => 1
+                ),
+                'dateBefore' => shape(
+                    'callback' => (mixed $input, RecordView $record, string $field) ==> $compare($input, $record->get($field), false),
+                    'references' => 1
+                ),
+                'match' => shape(
+                    'callback' => (mixed $input, RecordView $record, string $field) ==> ($input === $record->get($field)),
+                    'references' => 1
+                ),
+                'sumOf' => shape(
+                    'callback' => (mixed $input, RecordView $record, string $field) ==> {
+                        if (!is_numeric($input)) {
+                            return false;
+                        }
+
+                        $sum = 0.0;
+
+                        foreach ($record->getAll($field) as $value) {
+                            if (!is_numeric($value)) {
+                                return false;
+                            }
+
+                            $sum += (float) $value;
+                        }
+
+                        return (abs($sum - (float) $input) < 0.000001);
+                    },
+                    'references' => 1
+                )
+            };
+        });
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getOptionTypes(): Map<string, Vector<OptionType>> {
+        return ConstraintRegistry::loadMap(static::class, 'optionTypes', () ==> {
+            return Map {
+                'between' => Vector {OptionType::INT, OptionType::INT},
+                'decimal' => Vector {OptionType::INT},
+                'email' => Vector {OptionType::BOOL},
+                'exact' => Vector {OptionType::INT},
+                'inList' => Vector {OptionType::SET},
+                'inRange' => Vector {OptionType::FLOAT, OptionType::FLOAT},
+                'ip' => Vector {OptionType::INT},
+                'maxLength' => Vector {OptionType::INT},
+                'minLength' => Vector {OptionType::INT}
+            };
+        });
+    }
+
+    /**
+     * {@inheritdoc}
+     */
+    public function getPatternConstraints(): Map<string, int> {
+        return ConstraintRegistry::loadMap(static::class, 'patternConstraints', () ==> {
+            return Map {'custom' => 0};
+        });
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * Constraints that hit the network or file system, like DNS checks or file uploads, are excluded.
+     */
+    public function getPureConstraints(): Set<string> {
+        return ConstraintRegistry::loadMap(static::class, 'pureConstraints', () ==> {
+            return Set {
+                'alpha', 'alphaNumeric', 'between', 'boolean', 'comparison', 'creditCard', 'currency', 'custom',
+                'date', 'decimal', 'equal', 'exact', 'inList', 'inRange', 'ip', 'luhn', 'maxLength', 'minLength',
+                'notEmpty', 'numeric', 'phone', 'postalCode', 'ssn', 'time', 'url', 'uuid'
+            };
+        });
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * Length checks on strings count characters directly, and range checks on numbers compare without coercion.
+     * Variants receive the options parsed by their option types.
+     */
+    public function getScalarConstraints(): ScalarConstraintMap {
+        return ConstraintRegistry::loadMap(static::class, 'scalarConstraints', () ==> {
             // UNSAFE
-            // Since `class_meth()` requires literal strings and we are passing variables
-            $constraints[$method] = class_meth($class, $method);
-        }
+            // Since the callbacks accept a typed value and options
+            return Map {
+                'between' => Map {
+                    FieldType::STRING => (string $input, int $min, int $max) ==> {
+                        $length = mb_strlen($input);
 
-        return $constraints;
+                        return ($length >= $min && $length <= $max);
+                    }
+                },
+                'boolean' => Map {
+                    FieldType::BOOL => (bool $input) ==> true
+                },
+                'exact' => Map {
+                    FieldType::STRING => (string $input, int $length) ==> (mb_strlen($input) === $length)
+                },
+                'inList' => Map {
+                    FieldType::STRING => (string $input, ImmSet<string> $list) ==> $list->contains($input)
+                },
+                'inRange' => Map {
+                    FieldType::INT => (int $input, float $min, float $max) ==> ($input >= $min && $input <= $max),
+                    FieldType::FLOAT => (float $input, float $min, float $max) ==> ($input >= $min && $input <= $max)
+                },
+                'maxLength' => Map {
+                    FieldType::STRING => (string $input, int $max) ==> (mb_strlen($input) <= $max)
+                },
+                'minLength' => Map {
+                    FieldType::STRING => (string $input, int $min) ==> (mb_strlen($input) >= $min)
+                },
+                'numeric' => Map {
+                    FieldType::INT => (int $input) ==> true,
+                    FieldType::FLOAT => (float $input) ==> true
+                }
+            };
+        });
+    }
+
+    /**
+     * {@inheritdoc}
+     *
+     * The list for `inList` is parsed into a set, so membership is a hash lookup on the value's string form.
+     */
+    public function getTypedConstraints(): ConstraintMap {
+        return ConstraintRegistry::loadMap(static::class, 'typedConstraints', () ==> {
+            // UNSAFE
+            // Since the callbacks accept options beyond the value
+            return Map {
+                'inList' => (mixed $input, ImmSet<string> $list) ==> (is_scalar($input) && $list->contains((string) $input))
+            };
+        });
     }
 
 }
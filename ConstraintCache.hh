@@ -0,0 +1,210 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+use \Countable;
+
+/**
+ * A bounded least-recently-used cache of constraint results keyed by rule, options and value.
+ * Entries expire after a time-to-live, and a single cache can be shared by any number of schemas and validators.
+ *
+ * @package Titon\Validate
+ */
+class ConstraintCache implements Countable {
+
+    /**
+     * Maximum number of entries held before the least recently used is evicted.
+     *
+     * @var int
+     */
+    protected int $capacity;
+
+    /**
+     * Cached results mapped by key. The first entry is the least recently used.
+     *
+     * @var Map<string, Pair<bool, int>>
+     */
+    protected Map<string, Pair<bool, int>> $entries = Map {};
+
+    /**
+     * Number of lookups that found a result.
+     *
+     * @var int
+     */
+    protected int $hits = 0;
+
+    /**
+     * Number of lookups that did not find a result.
+     *
+     * @var int
+     */
+    protected int $misses = 0;
+
+    /**
+     * Number of seconds a result is valid for. Zero never expires.
+     *
+     * @var int
+     */
+    protected int $ttl;
+
+    /**
+     * Set the capacity and time-to-live.
+     *
+     * @param int $capacity
+     * @param int $ttl
+     */
+    public function __construct(int $capacity = 10000, int $ttl = 60) {
+        $this->capacity = max(1, $capacity);
+        $this->ttl = max(0, $ttl);
+    }
+
+    /**
+     * Return the number of cached results.
+     *
+     * @return int
+     */
+    public function count(): int {
+        return $this->entries->count();
+    }
+
+    /**
+     * Remove all cached results.
+     *
+     * @return $this
+     */
+    public function flush(): this {
+        $this->entries->clear();
+
+        return $this;
+    }
+
+    /**
+     * Return a cached result, or null if none exists or it has expired.
+     *
+     * @param string $key
+     * @return bool
+     */
+    public function get(string $key): ?bool {
+        $entry = $this->entries->get($key);
+
+        if ($entry === null) {
+            $this->misses++;
+
+            return null;
+        }
+
+        $this->entries->remove($key);
+
+        if ($entry[1] && $entry[1] < time()) {
+            $this->misses++;
+
+            return null;
+        }
+
+        // Move the entry to the end of the list, as it is now the most recently used
+        $this->entries[$key] = $entry;
+        $this->hits++;
+
+        return $entry[0];
+    }
+
+    /**
+     * Return the maximum number of cached results.
+     *
+     * @return int
+     */
+    public function getCapacity(): int {
+        return $this->capacity;
+    }
+
+    /**
+     * Return the number of lookups that found a result.
+     *
+     * @return int
+     */
+    public function getHits(): int {
+        return $this->hits;
+    }
+
+    /**
+     * Return the number of lookups that did not find a result.
+     *
+     * @return int
+     */
+    public function getMisses(): int {
+        return $this->misses;
+    }
+
+    /**
+     * Return the number of seconds a result is cached for.
+     *
+     * @return int
+     */
+    public function getTtl(): int {
+        return $this->ttl;
+    }
+
+    /**
+     * Cache a result, evicting the least recently used result if the cache is full.
+     *
+     * @param string $key
+     * @param bool $result
+     * @return $this
+     */
+    public function set(string $key, bool $result): this {
+        $this->entries->remove($key);
+
+        if ($this->entries->count() >= $this->capacity) {
+            foreach ($this->entries as $oldest => $entry) {
+                $this->entries->remove($oldest);
+                break;
+            }
+        }
+
+        $this->entries[$key] = Pair {$result, $this->ttl ? time() + $this->ttl : 0};
+
+        return $this;
+    }
+
+    /**
+     * Return the cache key for a rule and value, or null if the value is not a scalar and can not be cached.
+     *
+     * @param \Titon\Validate\CompiledRule $rule
+     * @param mixed $value
+     * @return string
+     */
+    public static function key(CompiledRule $rule, mixed $value): ?string {
+        $key = static::valueKey($value);
+
+        return ($key === null) ? null : $rule['key'] . '|' . $key;
+    }
+
+    /**
+     * Return a type-prefixed key for a scalar value, or null if the value is not a scalar.
+     * The prefix keeps values like `1`, `'1'` and `true` apart.
+     *
+     * @param mixed $value
+     * @return string
+     */
+    public static function valueKey(mixed $value): ?string {
+        if (is_string($value)) {
+            return 's:' . $value;
+        } else if (is_int($value)) {
+            return 'i:' . $value;
+        } else if (is_float($value)) {
+            return 'f:' . sprintf('%.17g', $value);
+        } else if (is_bool($value)) {
+            return $value ? 'b:1' : 'b:0';
+        } else if ($value === null) {
+            return 'n';
+        }
+
+        return null;
+    }
+
+}
@@ -16,6 +16,7 @@ interface ConstraintProvider {
 
     /**
      * Return a map of constraint callbacks with the key being the rule name.
+     * The map may be shared between validators, so it should not be modified after being returned.
      *
      * @return \Titon\Validate\ConstraintMap
      */
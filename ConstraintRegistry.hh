@@ -0,0 +1,149 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * A process-wide registry of constraint maps keyed by provider class.
+ * Providers fill their entries once and every validator afterwards shares the same maps and closures.
+ *
+ * @package Titon\Validate
+ */
+class ConstraintRegistry {
+
+    /**
+     * Bulk constraint maps keyed by provider class name.
+     *
+     * @var Map<string, \Titon\Validate\BulkConstraintMap>
+     */
+    protected static Map<string, BulkConstraintMap> $bulkConstraints = Map {};
+
+    /**
+     * Constraint maps keyed by provider class name.
+     *
+     * @var Map<string, \Titon\Validate\ConstraintMap>
+     */
+    protected static Map<string, ConstraintMap> $constraints = Map {};
+
+    /**
+     * Other provider maps, like costs, option types and constraint variants, keyed by provider class name and map name.
+     *
+     * @var Map<string, Map<string, mixed>>
+     */
+    protected static Map<string, Map<string, mixed>> $maps = Map {};
+
+    /**
+     * Remove all registered constraint maps.
+     */
+    public static function flush(): void {
+        static::$constraints->clear();
+        static::$bulkConstraints->clear();
+        static::$maps->clear();
+    }
+
+    /**
+     * Return the constraint map for a class, or null if it has not been registered.
+     *
+     * @param string $class
+     * @return \Titon\Validate\ConstraintMap
+     */
+    public static function get(string $class): ?ConstraintMap {
+        return static::$constraints->get($class);
+    }
+
+    /**
+     * Return true if the class has a registered constraint map.
+     *
+     * @param string $class
+     * @return bool
+     */
+    public static function has(string $class): bool {
+        return static::$constraints->contains($class);
+    }
+
+    /**
+     * Return the constraint map for a class. If it has not been registered,
+     * the factory will be called once and its result stored for the lifetime of the process.
+     *
+     * The returned map is shared, so it should be treated as read-only.
+     *
+     * @param string $class
+     * @param (function(): \Titon\Validate\ConstraintMap) $factory
+     * @return \Titon\Validate\ConstraintMap
+     */
+    public static function load(string $class, (function(): ConstraintMap) $factory): ConstraintMap {
+        $constraints = static::$constraints->get($class);
+
+        if ($constraints === null) {
+            $constraints = $factory();
+
+            static::$constraints[$class] = $constraints;
+        }
+
+        return $constraints;
+    }
+
+    /**
+     * Return the bulk constraint map for a class, calling the factory once if it has not been registered.
+     *
+     * The returned map is shared, so it should be treated as read-only.
+     *
+     * @param string $class
+     * @param (function(): \Titon\Validate\BulkConstraintMap) $factory
+     * @return \Titon\Validate\BulkConstraintMap
+     */
+    public static function loadBulk(string $class, (function(): BulkConstraintMap) $factory): BulkConstraintMap {
+        $constraints = static::$bulkConstraints->get($class);
+
+        if ($constraints === null) {
+            $constraints = $factory();
+
+            static::$bulkConstraints[$class] = $constraints;
+        }
+
+        return $constraints;
+    }
+
+    /**
+     * Return a named map of a class, calling the factory once if it has not been registered.
+     * This is used for every provider map other than constraints and bulk constraints.
+     *
+     * The returned map is shared, so it should be treated as read-only.
+     *
+     * @param string $class
+     * @param string $name
+     * @param (function(): T) $factory
+     * @return T
+     */
+    public static function loadMap<T>(string $class, string $name, (function(): T) $factory): T {
+        if (!static::$maps->contains($class)) {
+            static::$maps[$class] = Map {};
+        }
+
+        $maps = static::$maps[$class];
+
+        if (!$maps->contains($name)) {
+            $maps[$name] = $factory();
+        }
+
+        // UNSAFE
+        // Since maps of every type are stored together, and the name decides the type
+        return $maps[$name];
+    }
+
+    /**
+     * Remove the constraint maps for a class.
+     *
+     * @param string $class
+     */
+    public static function remove(string $class): void {
+        static::$constraints->remove($class);
+        static::$bulkConstraints->remove($class);
+        static::$maps->remove($class);
+    }
+
+}
@@ -0,0 +1,25 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Provides a cost hint for constraints, in estimated microseconds per call.
+ * Hints are used to order the rules of a field when a schema runs rules cheapest first.
+ *
+ * @package Titon\Validate
+ */
+interface CostConstraintProvider {
+
+    /**
+     * Return a map of constraint names to their estimated cost.
+     *
+     * @return Map<string, float>
+     */
+    public function getConstraintCosts(): Map<string, float>;
+
+}
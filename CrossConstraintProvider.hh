@@ -0,0 +1,26 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Provides constraints that compare a value to other fields of the same record.
+ * A cross-field constraint receives the value, a read-only view of the record, and the rule's options,
+ * where the leading options name the fields it references, so that the schema knows which fields depend on which.
+ *
+ * @package Titon\Validate
+ */
+interface CrossConstraintProvider {
+
+    /**
+     * Return a map of cross-field constraints with the key being the rule name.
+     *
+     * @return \Titon\Validate\CrossConstraintMap
+     */
+    public function getCrossConstraints(): CrossConstraintMap;
+
+}
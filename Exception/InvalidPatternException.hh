@@ -0,0 +1,17 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate\Exception;
+
+/**
+ * Exception thrown when a rule's regex pattern can not be compiled.
+ *
+ * @package Titon\Validate\Exception
+ */
+class InvalidPatternException extends \InvalidArgumentException {
+
+}
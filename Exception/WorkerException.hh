@@ -0,0 +1,17 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate\Exception;
+
+/**
+ * Exception thrown when a worker process fails to validate its chunk of a batch.
+ *
+ * @package Titon\Validate\Exception
+ */
+class WorkerException extends \RuntimeException {
+
+}
@@ -0,0 +1,29 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Scalar types a field can declare its values to be.
+ * Values of the declared type are passed to scalar variants of constraints,
+ * while values of any other type fall back to the original constraints.
+ *
+ *  MIXED   - No type is declared
+ *  STRING  - Values are strings
+ *  INT     - Values are integers
+ *  FLOAT   - Values are floats
+ *  BOOL    - Values are booleans
+ *
+ * @package Titon\Validate
+ */
+enum FieldType : int {
+    MIXED = 0;
+    STRING = 1;
+    INT = 2;
+    FLOAT = 3;
+    BOOL = 4;
+}
@@ -0,0 +1,305 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Collects call counts, failure counts and cumulative time per schema, field and rule,
+ * as well as the cost of building schemas and rendering messages.
+ *
+ * Counters are stored per schema as vectors indexed by the schema wide rule index, so recording is a couple of
+ * integer additions. Only one in every N records is timed, as defined by the sample rate,
+ * and counters are not scaled, so multiply them by the sample rate to estimate totals.
+ *
+ * @package Titon\Validate
+ */
+class Instrumentation {
+
+    /**
+     * Number of builds and cumulative build time, mapped by schema name.
+     *
+     * @var Map<string, Pair<int, float>>
+     */
+    protected Map<string, Pair<int, float>> $builds = Map {};
+
+    /**
+     * Number of constraint calls per rule, mapped by schema name.
+     *
+     * @var Map<string, Vector<int>>
+     */
+    protected Map<string, Vector<int>> $calls = Map {};
+
+    /**
+     * Number of records seen since the last sample.
+     *
+     * @var int
+     */
+    protected int $counter = 0;
+
+    /**
+     * Number of failed constraint calls per rule, mapped by schema name.
+     *
+     * @var Map<string, Vector<int>>
+     */
+    protected Map<string, Vector<int>> $failures = Map {};
+
+    /**
+     * Number of rendered messages per rule, mapped by schema name.
+     *
+     * @var Map<string, Vector<int>>
+     */
+    protected Map<string, Vector<int>> $messages = Map {};
+
+    /**
+     * Cumulative message rendering time in seconds per rule, mapped by schema name.
+     *
+     * @var Map<string, Vector<float>>
+     */
+    protected Map<string, Vector<float>> $messageTime = Map {};
+
+    /**
+     * Time one in every N records.
+     *
+     * @var int
+     */
+    protected int $sampleRate;
+
+    /**
+     * Registered schemas mapped by name, used to resolve rule indices into names.
+     *
+     * @var Map<string, \Titon\Validate\CompiledSchema>
+     */
+    protected Map<string, CompiledSchema> $schemas = Map {};
+
+    /**
+     * Cumulative constraint time in seconds per rule, mapped by schema name.
+     *
+     * @var Map<string, Vector<float>>
+     */
+    protected Map<string, Vector<float>> $time = Map {};
+
+    /**
+     * Store the sample rate.
+     *
+     * @param int $sampleRate
+     */
+    public function __construct(int $sampleRate = 1) {
+        $this->sampleRate = max($sampleRate, 1);
+    }
+
+    /**
+     * Allocate zeroed counters for every rule of a schema.
+     *
+     * @param string $name
+     * @param int $rules
+     */
+    protected function allocate(string $name, int $rules): void {
+        $ints = Vector {};
+        $ints->resize($rules, 0);
+
+        $floats = Vector {};
+        $floats->resize($rules, 0.0);
+
+        $this->calls[$name] = $ints;
+        $this->failures[$name] = $ints->toVector();
+        $this->messages[$name] = $ints->toVector();
+        $this->time[$name] = $floats;
+        $this->messageTime[$name] = $floats->toVector();
+    }
+
+    /**
+     * Reset all counters while keeping registered schemas.
+     *
+     * @return $this
+     */
+    public function flush(): this {
+        $this->builds->clear();
+        $this->counter = 0;
+
+        foreach ($this->schemas as $name => $schema) {
+            $this->allocate($name, $schema->getRuleCount());
+        }
+
+        return $this;
+    }
+
+    /**
+     * Return the learned cost of each rule name, as the average microseconds per call divided by the rate of failure,
+     * so that cheap rules that often fail are ordered first. Rules that were never called are omitted.
+     *
+     * @return Map<string, float>
+     */
+    public function getCosts(): Map<string, float> {
+        $totals = Map {};
+
+        foreach ($this->schemas as $name => $schema) {
+            foreach ($this->calls[$name] as $bit => $calls) {
+                if ($calls === 0) {
+                    continue;
+                }
+
+                $index = $schema->getRuleAt($bit);
+                $rule = $schema->getFieldAt($index[0])['rules'][$index[1]]['rule'];
+                $total = $totals->get($rule) ?: Vector {0, 0, 0.0};
+
+                $total[0] += $calls;
+                $total[1] += $this->failures[$name][$bit];
+                $total[2] += $this->time[$name][$bit];
+
+                $totals[$rule] = $total;
+            }
+        }
+
+        return $totals->map($total ==> ($total[2] * 1000000 / $total[0]) / max($total[1] / $total[0], 0.01));
+    }
+
+    /**
+     * Return the sample rate.
+     *
+     * @return int
+     */
+    public function getSampleRate(): int {
+        return $this->sampleRate;
+    }
+
+    /**
+     * Record the time it took to build a schema.
+     *
+     * @param string $name
+     * @param float $time
+     */
+    public function recordBuild(string $name, float $time): void {
+        $build = $this->builds->get($name);
+
+        $this->builds[$name] = ($build === null) ? Pair {1, $time} : Pair {$build[0] + 1, $build[1] + $time};
+    }
+
+    /**
+     * Record a constraint call for the rule at the schema wide index.
+     *
+     * @param string $name
+     * @param int $bit
+     * @param bool $passed
+     * @param float $time
+     */
+    public function recordCall(string $name, int $bit, bool $passed, float $time): void {
+        $this->calls[$name][$bit]++;
+        $this->time[$name][$bit] += $time;
+
+        if (!$passed) {
+            $this->failures[$name][$bit]++;
+        }
+    }
+
+    /**
+     * Record a batch of constraint calls for the rule at the schema wide index, as made by the columnar engine.
+     *
+     * @param string $name
+     * @param int $bit
+     * @param int $calls
+     * @param int $failures
+     * @param float $time
+     */
+    public function recordCalls(string $name, int $bit, int $calls, int $failures, float $time): void {
+        $this->calls[$name][$bit] += $calls;
+        $this->failures[$name][$bit] += $failures;
+        $this->time[$name][$bit] += $time;
+    }
+
+    /**
+     * Record the rendering of a message for the rule at the schema wide index.
+     *
+     * @param string $name
+     * @param int $bit
+     * @param float $time
+     */
+    public function recordMessage(string $name, int $bit, float $time): void {
+        $this->messages[$name][$bit]++;
+        $this->messageTime[$name][$bit] += $time;
+    }
+
+    /**
+     * Register a schema under a name. Counters are reset when the number of rules has changed.
+     *
+     * @param string $name
+     * @param \Titon\Validate\CompiledSchema $schema
+     * @return $this
+     */
+    public function register(string $name, CompiledSchema $schema): this {
+        $count = $schema->getRuleCount();
+
+        if (!$this->calls->contains($name) || $this->calls[$name]->count() !== $count) {
+            $this->allocate($name, $count);
+        }
+
+        $this->schemas[$name] = $schema;
+
+        return $this;
+    }
+
+    /**
+     * Return true if the current record should be timed.
+     *
+     * @return bool
+     */
+    public function sample(): bool {
+        if (++$this->counter >= $this->sampleRate) {
+            $this->counter = 0;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Return a snapshot of all counters, with rule indices resolved into field and rule names.
+     * Rules that have not been called or rendered are omitted.
+     *
+     * @return \Titon\Validate\InstrumentationSnapshot
+     */
+    public function snapshot(): InstrumentationSnapshot {
+        $builds = Vector {};
+        $rules = Vector {};
+
+        foreach ($this->builds as $name => $build) {
+            $builds[] = shape('schema' => $name, 'builds' => $build[0], 'time' => $build[1]);
+        }
+
+        foreach ($this->schemas as $name => $schema) {
+            $calls = $this->calls[$name];
+            $messages = $this->messages[$name];
+
+            foreach ($calls as $bit => $count) {
+                if ($count === 0 && $messages[$bit] === 0) {
+                    continue;
+                }
+
+                $index = $schema->getRuleAt($bit);
+                $field = $schema->getFieldAt($index[0]);
+
+                $rules[] = shape(
+                    'schema' => $name,
+                    'field' => $field['field'],
+                    'rule' => $field['rules'][$index[1]]['rule'],
+                    'calls' => $count,
+                    'failures' => $this->failures[$name][$bit],
+                    'time' => $this->time[$name][$bit],
+                    'messages' => $messages[$bit],
+                    'messageTime' => $this->messageTime[$name][$bit]
+                );
+            }
+        }
+
+        return shape(
+            'sampleRate' => $this->sampleRate,
+            'builds' => $builds,
+            'rules' => $rules
+        );
+    }
+
+}
@@ -0,0 +1,176 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * The error messages of a single locale, pre-tokenized into templates.
+ * Messages are keyed by rule name, or by field and rule name joined with a dot to override a single field.
+ *
+ * Catalogs are loaded once per locale into a process-wide registry, so every validator and result of a locale
+ * shares the same templates, while the schemas and their rules are shared across all locales.
+ * Rules without a message in the catalog fall back to the message of the schema.
+ *
+ * @package Titon\Validate
+ */
+class MessageCatalog {
+
+    /**
+     * Catalogs keyed by locale.
+     *
+     * @var Map<string, \Titon\Validate\MessageCatalog>
+     */
+    protected static Map<string, MessageCatalog> $catalogs = Map {};
+
+    /**
+     * Templates that override a single field, keyed by field and rule name.
+     *
+     * @var ImmMap<string, \Titon\Validate\MessageTemplate>
+     */
+    protected ImmMap<string, MessageTemplate> $fields;
+
+    /**
+     * The locale of the messages.
+     *
+     * @var string
+     */
+    protected string $locale;
+
+    /**
+     * Templates keyed by rule name.
+     *
+     * @var ImmMap<string, \Titon\Validate\MessageTemplate>
+     */
+    protected ImmMap<string, MessageTemplate> $rules;
+
+    /**
+     * Store the locale and tokenize every message. Keys containing a dot override a single field.
+     *
+     * @param string $locale
+     * @param \Titon\Validate\MessageMap $messages
+     */
+    public function __construct(string $locale, MessageMap $messages) {
+        $fields = Map {};
+        $rules = Map {};
+
+        foreach ($messages as $key => $message) {
+            if (strpos($key, '.') === false) {
+                $rules[$key] = new MessageTemplate($message);
+            } else {
+                $fields[$key] = new MessageTemplate($message);
+            }
+        }
+
+        $this->locale = $locale;
+        $this->fields = $fields->toImmMap();
+        $this->rules = $rules->toImmMap();
+    }
+
+    /**
+     * Return the locale of the messages.
+     *
+     * @return string
+     */
+    public function getLocale(): string {
+        return $this->locale;
+    }
+
+    /**
+     * Return the raw messages, keyed as they were loaded.
+     *
+     * @return \Titon\Validate\MessageMap
+     */
+    public function getMessages(): MessageMap {
+        $messages = Map {};
+
+        foreach ($this->rules as $key => $template) {
+            $messages[$key] = $template->getMessage();
+        }
+
+        foreach ($this->fields as $key => $template) {
+            $messages[$key] = $template->getMessage();
+        }
+
+        return $messages;
+    }
+
+    /**
+     * Return the template for a rule of a field, or null if the catalog has no message for it.
+     * A message for the field takes precedence over a message for the rule.
+     *
+     * @param string $field
+     * @param string $rule
+     * @return \Titon\Validate\MessageTemplate
+     */
+    public function getTemplate(string $field, string $rule): ?MessageTemplate {
+        if (!$this->fields->isEmpty()) {
+            $template = $this->fields->get($field . '.' . $rule);
+
+            if ($template !== null) {
+                return $template;
+            }
+        }
+
+        return $this->rules->get($rule);
+    }
+
+    /**
+     * Remove all registered catalogs.
+     */
+    public static function flush(): void {
+        static::$catalogs->clear();
+    }
+
+    /**
+     * Return the catalog for a locale, or null if it has not been registered.
+     *
+     * @param string $locale
+     * @return \Titon\Validate\MessageCatalog
+     */
+    public static function get(string $locale): ?MessageCatalog {
+        return static::$catalogs->get($locale);
+    }
+
+    /**
+     * Return the catalog for a locale. If it has not been registered,
+     * the factory will be called once and its messages tokenized and stored for the lifetime of the process.
+     *
+     * @param string $locale
+     * @param (function(): \Titon\Validate\MessageMap) $factory
+     * @return \Titon\Validate\MessageCatalog
+     */
+    public static function load(string $locale, (function(): MessageMap) $factory): MessageCatalog {
+        $catalog = static::$catalogs->get($locale);
+
+        if ($catalog === null) {
+            $catalog = new static($locale, $factory());
+
+            static::$catalogs[$locale] = $catalog;
+        }
+
+        return $catalog;
+    }
+
+    /**
+     * Register a catalog under its locale, replacing any catalog of that locale.
+     *
+     * @param \Titon\Validate\MessageCatalog $catalog
+     */
+    public static function register(MessageCatalog $catalog): void {
+        static::$catalogs[$catalog->getLocale()] = $catalog;
+    }
+
+    /**
+     * Remove the catalog for a locale.
+     *
+     * @param string $locale
+     */
+    public static function remove(string $locale): void {
+        static::$catalogs->remove($locale);
+    }
+
+}
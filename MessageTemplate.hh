@@ -0,0 +1,83 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * A pre-tokenized error message. The message is parsed once into literal and token segments,
+ * so that rendering is a plain concatenation of strings.
+ *
+ * @package Titon\Validate
+ */
+class MessageTemplate {
+
+    /**
+     * The raw message.
+     *
+     * @var string
+     */
+    protected string $message;
+
+    /**
+     * Alternating list of literal segments (even indices) and token names (odd indices).
+     *
+     * @var ImmVector<string>
+     */
+    protected ImmVector<string> $segments;
+
+    /**
+     * Parse the message into segments.
+     *
+     * @param string $message
+     */
+    public function __construct(string $message) {
+        $this->message = $message;
+        $this->segments = new ImmVector(preg_split('/\{([a-zA-Z0-9_\.]+)\}/', $message, -1, PREG_SPLIT_DELIM_CAPTURE));
+    }
+
+    /**
+     * Return the raw message.
+     *
+     * @return string
+     */
+    public function getMessage(): string {
+        return $this->message;
+    }
+
+    /**
+     * Return the names of all tokens used within the message.
+     *
+     * @return ImmVector<string>
+     */
+    public function getTokens(): ImmVector<string> {
+        return $this->segments->filterWithKey(($i, $segment) ==> ($i % 2) === 1)->values();
+    }
+
+    /**
+     * Render the message by concatenating literal segments and token values.
+     * Tokens without a value are left as is.
+     *
+     * @param ImmMap<string, string> $tokens
+     * @return string
+     */
+    public function render(ImmMap<string, string> $tokens): string {
+        $output = '';
+
+        foreach ($this->segments as $i => $segment) {
+            if ($i % 2 === 0) {
+                $output .= $segment;
+            } else if ($tokens->contains($segment)) {
+                $output .= $tokens[$segment];
+            } else {
+                $output .= '{' . $segment . '}';
+            }
+        }
+
+        return $output;
+    }
+
+}
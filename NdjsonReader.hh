@@ -0,0 +1,158 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+use Titon\Validate\Exception\InvalidRecordException;
+use \InvalidArgumentException;
+use \IteratorAggregate;
+
+/**
+ * Reads newline delimited JSON from a stream and yields one record at a time,
+ * so that memory is bounded by the size of a single record rather than the whole stream.
+ *
+ * @package Titon\Validate
+ */
+class NdjsonReader implements IteratorAggregate<DataMap> {
+
+    /**
+     * Lines that could not be decoded, mapped by line number, when not in strict mode.
+     *
+     * @var Map<int, string>
+     */
+    protected Map<int, string> $invalidLines = Map {};
+
+    /**
+     * Whether the stream was opened by the reader, and is closed by it.
+     *
+     * @var bool
+     */
+    protected bool $owned;
+
+    /**
+     * The stream to read from.
+     *
+     * @var resource
+     */
+    protected resource $stream;
+
+    /**
+     * Throw an exception on invalid lines instead of skipping them.
+     *
+     * @var bool
+     */
+    protected bool $strict;
+
+    /**
+     * Store the stream and reading options. A stream that is owned by the reader is closed once
+     * it has been read to the end, or when the reader is destroyed, otherwise the caller is responsible for closing it.
+     *
+     * @param resource $stream
+     * @param bool $strict
+     * @param bool $owned
+     * @throws \InvalidArgumentException
+     */
+    public function __construct(resource $stream, bool $strict = true, bool $owned = false) {
+        if (get_resource_type($stream) !== 'stream') {
+            throw new InvalidArgumentException('NDJSON reader requires a stream resource');
+        }
+
+        $this->stream = $stream;
+        $this->strict = $strict;
+        $this->owned = $owned;
+    }
+
+    /**
+     * Close the stream if it is owned by the reader.
+     */
+    public function __destruct() {
+        if ($this->owned) {
+            $this->close();
+        }
+    }
+
+    /**
+     * Close the stream, unless it has already been closed.
+     */
+    public function close(): void {
+        if (is_resource($this->stream)) {
+            fclose($this->stream);
+        }
+    }
+
+    /**
+     * Return the lines that could not be decoded, mapped by line number, along with the reason.
+     *
+     * @return Map<int, string>
+     */
+    public function getInvalidLines(): Map<int, string> {
+        return $this->invalidLines;
+    }
+
+    /**
+     * Yield each decoded record from the stream. Blank lines are ignored, and lines that are not a JSON object are invalid.
+     *
+     * @return Iterator<\Titon\Validate\DataMap>
+     * @throws \Titon\Validate\Exception\InvalidRecordException
+     */
+    public function getIterator(): Iterator<DataMap> {
+        $line = 0;
+
+        while (($buffer = fgets($this->stream)) !== false) {
+            $line++;
+            $buffer = trim($buffer);
+
+            if ($buffer === '') {
+                continue;
+            }
+
+            // Lists and scalars are valid JSON, but do not form a record with field names
+            if ($buffer[0] !== '{') {
+                $reason = 'Record is not an object';
+
+            } else {
+                $record = json_decode($buffer, true);
+
+                if (is_array($record)) {
+                    yield new Map($record);
+                    continue;
+                }
+
+                $reason = json_last_error_msg();
+            }
+
+            if ($this->strict) {
+                throw new InvalidRecordException(sprintf('Invalid record on line %s: %s', $line, $reason));
+            }
+
+            $this->invalidLines[$line] = $reason;
+        }
+
+        if ($this->owned) {
+            $this->close();
+        }
+    }
+
+    /**
+     * Open a file or URL for reading and return a reader for it. The reader owns the stream and closes it.
+     *
+     * @param string $path
+     * @param bool $strict
+     * @return \Titon\Validate\NdjsonReader
+     * @throws \InvalidArgumentException
+     */
+    public static function open(string $path, bool $strict = true): NdjsonReader {
+        $stream = fopen($path, 'rb');
+
+        if (!$stream) {
+            throw new InvalidArgumentException(sprintf('Unable to open %s for reading', $path));
+        }
+
+        return new NdjsonReader($stream, $strict, true);
+    }
+
+}
@@ -0,0 +1,31 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Types that rule options are parsed into when a schema is compiled.
+ *
+ *  MIXED   - Passed through as is
+ *  STRING  - Cast to a string
+ *  INT     - Parsed from a numeric value into an integer
+ *  FLOAT   - Parsed from a numeric value into a float
+ *  BOOL    - Parsed from a boolean or a string like "true", "false", "1" or "0"
+ *  LIST    - An immutable vector, built from the remaining options when not already a collection
+ *  SET     - An immutable set of strings for constant time lookups, built like a list
+ *
+ * @package Titon\Validate
+ */
+enum OptionType : int {
+    MIXED = 0;
+    STRING = 1;
+    INT = 2;
+    FLOAT = 3;
+    BOOL = 4;
+    LIST = 5;
+    SET = 6;
+}
@@ -0,0 +1,301 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+use Titon\Validate\Exception\WorkerException;
+use \InvalidArgumentException;
+
+/**
+ * Validates large batches by splitting the input into chunks and validating each chunk in a forked process.
+ * Every worker inherits the same compiled schema, and only the packed failure bits are sent back to the parent.
+ * Chunk results are yielded in the original order, keyed by the index of their first record.
+ *
+ * Input is read lazily, and no more than a fixed number of chunks are in flight or waiting to be yielded,
+ * so a slow chunk pauses the reading of input instead of buffering the results of every other chunk.
+ * When process control is not available, chunks are validated in the current process.
+ *
+ * @package Titon\Validate
+ */
+class ParallelBatchRunner {
+
+    /**
+     * Number of records per chunk.
+     *
+     * @var int
+     */
+    protected int $chunkSize;
+
+    /**
+     * Maximum number of chunks that are being validated or are waiting to be yielded.
+     *
+     * @var int
+     */
+    protected int $maxPending;
+
+    /**
+     * The schema shared by all workers.
+     *
+     * @var \Titon\Validate\CompiledSchema
+     */
+    protected CompiledSchema $schema;
+
+    /**
+     * Number of concurrent worker processes.
+     *
+     * @var int
+     */
+    protected int $workers;
+
+    /**
+     * Store the schema and the runner settings. The number of pending chunks defaults to twice the number of workers.
+     *
+     * @param \Titon\Validate\CompiledSchema $schema
+     * @param int $workers
+     * @param int $chunkSize
+     * @param int $maxPending
+     * @throws \InvalidArgumentException
+     */
+    public function __construct(CompiledSchema $schema, int $workers = 4, int $chunkSize = 10000, int $maxPending = 0) {
+        if ($workers < 1 || $chunkSize < 1) {
+            throw new InvalidArgumentException('Parallel batch runner requires at least 1 worker and a chunk size of at least 1');
+        }
+
+        $this->schema = $schema;
+        $this->workers = $workers;
+        $this->chunkSize = $chunkSize;
+        $this->maxPending = max($maxPending ?: $workers * 2, $workers);
+    }
+
+    /**
+     * Split records into chunks while they are being read.
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return Iterator<Vector<\Titon\Validate\DataMap>>
+     */
+    protected function chunk(Traversable<DataMap> $records): Iterator<Vector<DataMap>> {
+        $chunk = Vector {};
+
+        foreach ($records as $data) {
+            $chunk[] = $data;
+
+            if ($chunk->count() >= $this->chunkSize) {
+                yield $chunk;
+
+                $chunk = Vector {};
+            }
+        }
+
+        if (!$chunk->isEmpty()) {
+            yield $chunk;
+        }
+    }
+
+    /**
+     * Read output from running workers, and unpack the results of workers that have finished.
+     * Blocks until at least one worker has written output or a second has passed.
+     *
+     * @param Map<int, Pair<int, resource>> $running
+     * @param Map<int, string> $buffers
+     * @param Map<int, \Titon\Validate\BatchResult> $done
+     * @throws \Titon\Validate\Exception\WorkerException
+     */
+    protected function collect(Map<int, Pair<int, resource>> $running, Map<int, string> $buffers, Map<int, BatchResult> $done): void {
+        if ($running->isEmpty()) {
+            return;
+        }
+
+        $read = $running->map($worker ==> $worker[1])->values()->toArray();
+        $write = null;
+        $except = null;
+
+        if (!stream_select($read, $write, $except, 1)) {
+            return;
+        }
+
+        foreach ($running->toMap() as $i => $worker) {
+            $output = fread($worker[1], 65536);
+
+            if (is_string($output) && $output !== '') {
+                $buffers[$i] .= $output;
+
+            } else if (feof($worker[1])) {
+                $status = 0;
+
+                fclose($worker[1]);
+                pcntl_waitpid($worker[0], $status);
+
+                $done[$i] = $this->unpack($i, $buffers[$i]);
+                $running->remove($i);
+                $buffers->remove($i);
+            }
+        }
+    }
+
+    /**
+     * Fork a worker that validates a chunk and writes the packed results to a socket.
+     * If a process can not be forked, the chunk is validated in the current process.
+     *
+     * @param int $index
+     * @param Vector<\Titon\Validate\DataMap> $chunk
+     * @param Map<int, Pair<int, resource>> $running
+     * @param Map<int, string> $buffers
+     * @param Map<int, \Titon\Validate\BatchResult> $done
+     */
+    protected function dispatch(int $index, Vector<DataMap> $chunk, Map<int, Pair<int, resource>> $running, Map<int, string> $buffers, Map<int, BatchResult> $done): void {
+        $sockets = stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+        $pid = $sockets ? pcntl_fork() : -1;
+
+        if ($pid === -1) {
+            if ($sockets) {
+                fclose($sockets[0]);
+                fclose($sockets[1]);
+            }
+
+            $done[$index] = $this->schema->validateBatch($chunk);
+
+        } else if ($pid === 0) {
+            fclose($sockets[0]);
+
+            // The worker never returns into the caller, even when validation throws, and is killed instead of exiting,
+            // so that destructors and shutdown functions inherited from the parent are not run twice
+            try {
+                $batch = $this->schema->validateBatch($chunk);
+                $payload = serialize([$batch->getBits()->toArray(), $batch->count(), $batch->getRejections()->toArray()]);
+
+                for ($written = 0, $length = strlen($payload); $written < $length; $written += $bytes) {
+                    $bytes = (int) fwrite($sockets[1], substr($payload, $written, 65536));
+
+                    if ($bytes <= 0) {
+                        break;
+                    }
+                }
+            } finally {
+                fclose($sockets[1]);
+                posix_kill(posix_getpid(), SIGKILL);
+            }
+
+        } else {
+            fclose($sockets[1]);
+            stream_set_blocking($sockets[0], false);
+
+            $running[$index] = Pair {$pid, $sockets[0]};
+            $buffers[$index] = '';
+        }
+    }
+
+    /**
+     * Return the number of records per chunk.
+     *
+     * @return int
+     */
+    public function getChunkSize(): int {
+        return $this->chunkSize;
+    }
+
+    /**
+     * Return the maximum number of pending chunks.
+     *
+     * @return int
+     */
+    public function getMaxPending(): int {
+        return $this->maxPending;
+    }
+
+    /**
+     * Return the number of worker processes.
+     *
+     * @return int
+     */
+    public function getWorkers(): int {
+        return $this->workers;
+    }
+
+    /**
+     * Validate the records and yield the result of each chunk in the original order,
+     * keyed by the index of the chunk's first record.
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return KeyedIterator<int, \Titon\Validate\BatchResult>
+     * @throws \Titon\Validate\Exception\WorkerException
+     */
+    public function run(Traversable<DataMap> $records): KeyedIterator<int, BatchResult> {
+        if ($this->workers === 1 || !function_exists('pcntl_fork')) {
+            foreach ($this->chunk($records) as $i => $chunk) {
+                yield $i * $this->chunkSize => $this->schema->validateBatch($chunk);
+            }
+
+            return;
+        }
+
+        $running = Map {};
+        $buffers = Map {};
+        $done = Map {};
+        $next = 0;
+
+        foreach ($this->chunk($records) as $i => $chunk) {
+            // Stop reading input until a worker is free and there is room to buffer its result
+            while ($running->count() >= $this->workers || ($running->count() + $done->count()) >= $this->maxPending) {
+                $this->collect($running, $buffers, $done);
+
+                for (; $done->contains($next); $next++) {
+                    yield $next * $this->chunkSize => $done[$next];
+
+                    $done->remove($next);
+                }
+            }
+
+            $this->dispatch($i, $chunk, $running, $buffers, $done);
+        }
+
+        while (!$running->isEmpty() || !$done->isEmpty()) {
+            $this->collect($running, $buffers, $done);
+
+            for (; $done->contains($next); $next++) {
+                yield $next * $this->chunkSize => $done[$next];
+
+                $done->remove($next);
+            }
+        }
+    }
+
+    /**
+     * Validate the records and yield a result for each record in the original order.
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return Iterator<\Titon\Validate\ValidationResult>
+     * @throws \Titon\Validate\Exception\WorkerException
+     */
+    public function runRecords(Traversable<DataMap> $records): Iterator<ValidationResult> {
+        foreach ($this->run($records) as $batch) {
+            for ($i = 0, $count = $batch->count(); $i < $count; $i++) {
+                yield $batch->getResult($i);
+            }
+        }
+    }
+
+    /**
+     * Rebuild a chunk's batch result from the packed output of a worker.
+     *
+     * @param int $index
+     * @param string $output
+     * @return \Titon\Validate\BatchResult
+     * @throws \Titon\Validate\Exception\WorkerException
+     */
+    protected function unpack(int $index, string $output): BatchResult {
+        $packed = @unserialize($output);
+
+        if (!is_array($packed) || count($packed) !== 3) {
+            throw new WorkerException(sprintf('Worker for chunk %s exited without a result', $index));
+        }
+
+        // UNSAFE
+        // Since the packed output is a list of plain values
+        return new BatchResult($this->schema, new Vector($packed[0]), (int) $packed[1], new Map($packed[2]));
+    }
+
+}
@@ -0,0 +1,26 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Declares constraints of a provider that pass when the value matches a regex pattern passed as an option.
+ * Patterns of these constraints are compiled and validated once when a schema is built,
+ * and the constraint is replaced by a matcher bound to the pattern.
+ *
+ * @package Titon\Validate
+ */
+interface PatternConstraintProvider {
+
+    /**
+     * Return a map of constraint names to the index of the option that holds the pattern.
+     *
+     * @return Map<string, int>
+     */
+    public function getPatternConstraints(): Map<string, int>;
+
+}
@@ -0,0 +1,25 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Marks constraints of a provider as pure, meaning their result only depends on the value and options.
+ * Results of pure constraints may be memoized while validating a batch.
+ *
+ * @package Titon\Validate
+ */
+interface PureConstraintProvider {
+
+    /**
+     * Return the names of all constraints that are pure.
+     *
+     * @return Set<string>
+     */
+    public function getPureConstraints(): Set<string>;
+
+}
@@ -0,0 +1,130 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * A read-only view of the record being validated, passed to cross-field constraints.
+ * Fields are looked up by name, where a literal key takes precedence over a nested path,
+ * and nested values are resolved once per record no matter how many rules reference them.
+ *
+ * A compiled schema owns a single view that is pointed at each record in turn and emptied once validation is done,
+ * so a view must not be kept once the constraint returns, and a schema must not be used to validate
+ * another record from within one of its own constraints. Schemas derived from another schema own a view of their own.
+ *
+ * @package Titon\Validate
+ */
+class RecordView {
+
+    /**
+     * The record being validated.
+     *
+     * @var \Titon\Validate\DataMap
+     */
+    protected DataMap $data = Map {};
+
+    /**
+     * An empty record the view points at between records, which is never written to.
+     *
+     * @var \Titon\Validate\DataMap
+     */
+    protected DataMap $empty = Map {};
+
+    /**
+     * Split paths of the fields that have been looked up, mapped by field name. Kept across records.
+     *
+     * @var Map<string, ?ImmVector<string>>
+     */
+    protected Map<string, ?ImmVector<string>> $paths = Map {};
+
+    /**
+     * Values of nested paths resolved for the current record, mapped by field name.
+     *
+     * @var Map<string, ImmVector<mixed>>
+     */
+    protected Map<string, ImmVector<mixed>> $resolved = Map {};
+
+    /**
+     * Return true if the field has at least one value in the record.
+     *
+     * @param string $field
+     * @return bool
+     */
+    public function contains(string $field): bool {
+        return ($this->data->contains($field) || !$this->getAll($field)->isEmpty());
+    }
+
+    /**
+     * Return the value of a field, or the first value of a nested path, or null if the field has no value.
+     *
+     * @param string $field
+     * @return mixed
+     */
+    public function get(string $field): mixed {
+        if ($this->data->contains($field)) {
+            return $this->data[$field];
+        }
+
+        $values = $this->getAll($field);
+
+        return $values->isEmpty() ? null : $values[0];
+    }
+
+    /**
+     * Return all values of a field, which is more than one for a wildcard path.
+     *
+     * @param string $field
+     * @return ImmVector<mixed>
+     */
+    public function getAll(string $field): ImmVector<mixed> {
+        if ($this->resolved->contains($field)) {
+            return $this->resolved[$field];
+        }
+
+        if ($this->data->contains($field)) {
+            $values = ImmVector {$this->data[$field]};
+        } else {
+            if (!$this->paths->contains($field)) {
+                $this->paths[$field] = CompiledSchema::splitPath($field);
+            }
+
+            $path = $this->paths[$field];
+            $values = ($path !== null) ? CompiledSchema::walkPath($this->data, $path)->toImmVector() : ImmVector {};
+        }
+
+        $this->resolved[$field] = $values;
+
+        return $values;
+    }
+
+    /**
+     * Point the view at an empty record and forget the values resolved for the previous one,
+     * without allocating a new record each time.
+     *
+     * @return $this
+     */
+    public function release(): this {
+        return $this->reset($this->empty);
+    }
+
+    /**
+     * Point the view at another record and forget the values resolved for the previous one.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @return $this
+     */
+    public function reset(DataMap $data): this {
+        $this->data = $data;
+
+        if (!$this->resolved->isEmpty()) {
+            $this->resolved->clear();
+        }
+
+        return $this;
+    }
+
+}
@@ -0,0 +1,27 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Provides variants of constraints that are specialized for a single scalar type.
+ * A variant is only called with values of its type, so it can skip type checks and coercion,
+ * and receives the same options as the constraint it replaces, parsed when option types are declared.
+ * A variant must return the same result as the original constraint for every value of its type.
+ *
+ * @package Titon\Validate
+ */
+interface ScalarConstraintProvider {
+
+    /**
+     * Return a map of constraint names to their variants, keyed by field type.
+     *
+     * @return \Titon\Validate\ScalarConstraintMap
+     */
+    public function getScalarConstraints(): ScalarConstraintMap;
+
+}
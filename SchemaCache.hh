@@ -0,0 +1,184 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Persists compiled schemas in APC, or on disk when a directory is defined, so that workers
+ * can load a schema without parsing shorthand rules and options, or tokenizing messages, again.
+ * Schemas are keyed by a hash of their definition, bail mode, cost ordering and the export format version,
+ * so a changed definition, setting or format is compiled and stored under a new key. Stored schemas of another format are treated as missing.
+ *
+ * @package Titon\Validate
+ */
+class SchemaCache {
+
+    /**
+     * Directory to store schemas in. APC is used when empty.
+     *
+     * @var string
+     */
+    protected string $directory;
+
+    /**
+     * Prefix for APC keys.
+     *
+     * @var string
+     */
+    protected string $prefix = 'titon.validate.schema.';
+
+    /**
+     * Seconds that schemas are stored in APC. Zero stores them until the cache is cleared.
+     *
+     * @var int
+     */
+    protected int $ttl;
+
+    /**
+     * Validator that constraints are bound from when a schema is loaded.
+     *
+     * @var \Titon\Validate\Validator
+     */
+    protected Validator $validator;
+
+    /**
+     * Store the directory, the APC TTL, and the validator that provides constraints. Defaults to the core validator.
+     *
+     * @param string $directory
+     * @param int $ttl
+     * @param \Titon\Validate\Validator $validator
+     */
+    public function __construct(string $directory = '', int $ttl = 0, ?Validator $validator = null) {
+        $this->directory = rtrim($directory, '/');
+        $this->ttl = $ttl;
+        $this->validator = $validator ?: new CoreValidator();
+    }
+
+    /**
+     * Compile a set of shorthand or expanded rule sets with a copy of the validator, so that a compiled schema
+     * has the same constraints, conditions, costs and settings as a loaded one. The validator should not define fields of its own.
+     *
+     * @param Map<string, mixed> $fields
+     * @return \Titon\Validate\CompiledSchema
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function compile(Map<string, mixed> $fields): CompiledSchema {
+        return AbstractValidator::applyShorthand(clone $this->validator, $fields)->compile();
+    }
+
+    /**
+     * Return a stored schema, or null if it does not exist, cannot be read, or was stored in another export format.
+     *
+     * @param string $key
+     * @return \Titon\Validate\CompiledSchema
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function get(string $key): ?CompiledSchema {
+        if ($this->directory) {
+            $path = $this->getPath($key);
+            $payload = is_file($path) ? file_get_contents($path) : false;
+        } else {
+            $payload = apc_fetch($this->prefix . $key);
+        }
+
+        if (!is_string($payload)) {
+            return null;
+        }
+
+        $export = @unserialize($payload);
+
+        if (!is_array($export) || idx($export, 'version') !== CompiledSchema::EXPORT_VERSION) {
+            return null;
+        }
+
+        return CompiledSchema::fromExport($export, $this->validator);
+    }
+
+    /**
+     * Return the path of the file a schema is stored in.
+     *
+     * @param string $key
+     * @return string
+     */
+    public function getPath(string $key): string {
+        return $this->directory . '/' . $key . '.schema';
+    }
+
+    /**
+     * Return a compiled schema for a set of shorthand or expanded rule sets.
+     * The schema is loaded when it has been stored before, otherwise it is compiled and stored.
+     *
+     * @param Map<string, mixed> $fields
+     * @return \Titon\Validate\CompiledSchema
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function load(Map<string, mixed> $fields): CompiledSchema {
+        $validator = $this->validator;
+        $key = static::key($fields, $validator->getBailMode(), $validator->isCostOrdered(), $validator->isCostStrict());
+        $schema = $this->get($key);
+
+        if ($schema === null) {
+            $schema = $this->compile($fields);
+
+            $this->set($key, $schema);
+        }
+
+        return $schema;
+    }
+
+    /**
+     * Remove a stored schema.
+     *
+     * @param string $key
+     * @return bool
+     */
+    public function remove(string $key): bool {
+        if ($this->directory) {
+            $path = $this->getPath($key);
+
+            return (is_file($path) && unlink($path));
+        }
+
+        return (bool) apc_delete($this->prefix . $key);
+    }
+
+    /**
+     * Store a compiled schema. Files are written to a temporary file first and renamed,
+     * so that other workers never read a partially written schema.
+     *
+     * @param string $key
+     * @param \Titon\Validate\CompiledSchema $schema
+     * @return bool
+     */
+    public function set(string $key, CompiledSchema $schema): bool {
+        $payload = serialize($schema->export());
+
+        if ($this->directory) {
+            $path = $this->getPath($key);
+            $temp = $path . '.' . getmypid() . '.tmp';
+
+            return (file_put_contents($temp, $payload) !== false && rename($temp, $path));
+        }
+
+        return (bool) apc_store($this->prefix . $key, $payload, $this->ttl);
+    }
+
+    /**
+     * Return a key for a set of shorthand or expanded rule sets by hashing its definition, the settings that
+     * change the compiled schema, and the export format version.
+     *
+     * @param Map<string, mixed> $fields
+     * @param \Titon\Validate\BailMode $bail
+     * @param bool $ordering
+     * @param bool $strict
+     * @return string
+     */
+    public static function key(Map<string, mixed> $fields, BailMode $bail = BailMode::NONE, bool $ordering = false, bool $strict = true): string {
+        return md5(sprintf('%s|%s|%d|%d|%s', CompiledSchema::EXPORT_VERSION, $bail, $ordering, $strict, serialize($fields)));
+    }
+
+}
@@ -0,0 +1,339 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+use \Indexish;
+use \InvalidArgumentException;
+
+/**
+ * Generates the source of a validator class that is specialized for a single schema.
+ * The generated `validate()` is straight-line code, with constraint calls inlined and options written as literals,
+ * that sets the same failure bits as the compiled schema, in the order of its walk mode, bail mode and cost ordering.
+ * The result is kept like any other validation, and all other methods are inherited,
+ * so the class is a drop-in replacement for the original validator. No messages are written into the source,
+ * they are rendered from the result when read, through the catalog set with `setMessageCatalog()` if any.
+ *
+ * Only constraints that are static methods of the provider, pattern constraints, and the typed `inList` can be inlined.
+ * Closures and async constraints cannot be written as source, so schemas that use them are rejected.
+ *
+ * @package Titon\Validate
+ */
+class SchemaGenerator {
+
+    /**
+     * The provider whose static methods are called by the generated code.
+     *
+     * @var \Titon\Validate\ConstraintProvider
+     */
+    protected ConstraintProvider $provider;
+
+    /**
+     * The validator to generate code for.
+     *
+     * @var \Titon\Validate\Validator
+     */
+    protected Validator $validator;
+
+    /**
+     * Store the validator and the constraint provider. Defaults to the built-in constraints.
+     *
+     * @param \Titon\Validate\Validator $validator
+     * @param \Titon\Validate\ConstraintProvider $provider
+     */
+    public function __construct(Validator $validator, ?ConstraintProvider $provider = null) {
+        $this->validator = $validator;
+        $this->provider = $provider ?: new Constraint();
+    }
+
+    /**
+     * Return the condition that passes when a rule passes for `$value`.
+     *
+     * @param \Titon\Validate\CompiledRule $rule
+     * @return string
+     * @throws \InvalidArgumentException
+     */
+    protected function emitCondition(CompiledRule $rule): string {
+        $name = $rule['rule'];
+
+        if ($rule['async'] !== null) {
+            throw new InvalidArgumentException(sprintf('Async constraint %s cannot be generated', $name));
+        }
+
+        if ($rule['pattern'] !== null) {
+            return sprintf('(is_scalar($value) && preg_match(%s, (string) $value) === 1)', static::export($rule['pattern']));
+        }
+
+        // A set lookup on a literal array, which HHVM stores as a static array
+        if ($name === 'inList' && $rule['constraint'] === $this->validator->getTypedConstraints()->get($name)) {
+            $keys = [];
+
+            foreach ((new ImmVector($rule['arguments'][0]))->map($item ==> (string) $item) as $item) {
+                $keys[] = static::export($item) . ' => true';
+            }
+
+            return sprintf('(is_scalar($value) && array_key_exists((string) $value, [%s]))', implode(', ', $keys));
+        }
+
+        $class = get_class($this->provider);
+
+        if (!method_exists($class, $name) || $rule['constraint'] !== $this->provider->getConstraints()->get($name)) {
+            throw new InvalidArgumentException(sprintf('Constraint %s is not a static method of %s and cannot be generated', $name, $class));
+        }
+
+        $args = ['$value'];
+
+        foreach ($rule['arguments'] as $arg) {
+            $args[] = static::export($arg);
+        }
+
+        return sprintf('\\%s::%s(%s)', $class, $name, implode(', ', $args));
+    }
+
+    /**
+     * Return the checks of a field's rules against `$value`, where each failure sets the bit of its rule.
+     * Without strict cost ordering, the rules are emitted cheapest first, so that the same failure is found first.
+     * When bailing on the field within a loop over wildcard values, the loop is left on the first failure like `checkPath()`.
+     *
+     * @param \Titon\Validate\CompiledSchema $schema
+     * @param int $index
+     * @param string $indent
+     * @param bool $loop
+     * @return string
+     */
+    protected function emitChecks(CompiledSchema $schema, int $index, string $indent, bool $loop): string {
+        $field = $schema->getFieldAt($index);
+        $bail = $schema->getBailMode();
+        $offset = $schema->getRuleOffset($index);
+        $checks = [];
+        $order = ($schema->isCostOrdered() && !$schema->isCostStrict() && $bail !== BailMode::NONE) ? $schema->getRuleOrder($index) : $field['rules']->keys();
+
+        foreach ($order as $i) {
+            $bit = $offset + $i;
+            $check = sprintf("if (!%s) {\n%s    \$bits[%d] |= (1 << %d);\n", $this->emitCondition($field['rules'][$i]), $indent, $bit >> 6, $bit & 63);
+
+            if ($bail === BailMode::ALL) {
+                $check .= sprintf("\n%s    return;\n", $indent);
+            } else if ($bail === BailMode::FIELD && $loop) {
+                $check .= sprintf("\n%s    break;\n", $indent);
+            }
+
+            $checks[] = $check . $indent . '}';
+        }
+
+        // Only the first failing rule is recorded when bailing on the field
+        $glue = ($bail === BailMode::FIELD && !$loop) ? ' else ' : "\n\n" . $indent;
+
+        return $checks ? $indent . implode($glue, $checks) . "\n" : '';
+    }
+
+    /**
+     * Return the statements that validate a single field, either by its key or by walking its nested path.
+     *
+     * @param \Titon\Validate\CompiledSchema $schema
+     * @param int $index
+     * @return string
+     */
+    protected function emitField(CompiledSchema $schema, int $index): string {
+        $field = $schema->getFieldAt($index);
+        $key = static::export($field['field']);
+
+        if ($field['path'] !== null) {
+            $checks = $this->emitChecks($schema, $index, '            ', true);
+
+            return $checks ? sprintf("        foreach ((\$data->contains(%s) ? Vector {\$data[%s]} : \\Titon\\Validate\\CompiledSchema::walkPath(\$data, %s)) as \$value) {\n%s        }\n\n", $key, $key, static::export($field['path']), $checks) : '';
+        }
+
+        $checks = $this->emitChecks($schema, $index, '            ', false);
+
+        return $checks ? sprintf("        if (\$data->contains(%s)) {\n            \$value = \$data[%s];\n\n%s        }\n\n", $key, $key, $checks) : '';
+    }
+
+    /**
+     * Return the statements that validate the fields in the order of the record's keys, followed by nested paths
+     * that are not present as literal keys, as when the schema walks the data.
+     *
+     * @param \Titon\Validate\CompiledSchema $schema
+     * @return string
+     */
+    protected function emitWalk(CompiledSchema $schema): string {
+        $cases = '';
+        $paths = '';
+
+        foreach ($schema->getFields() as $index => $field) {
+            $key = static::export($field['field']);
+            $checks = $this->emitChecks($schema, $index, '                    ', false);
+
+            if (!$checks) {
+                continue;
+            }
+
+            $cases .= sprintf("                case %s:\n%s                    break;\n", $key, $checks);
+
+            if ($field['path'] !== null) {
+                $paths .= sprintf("        if (!\$data->contains(%s)) {\n            foreach (\\Titon\\Validate\\CompiledSchema::walkPath(\$data, %s) as \$value) {\n%s            }\n        }\n\n", $key, static::export($field['path']), $this->emitChecks($schema, $index, '                ', true));
+            }
+        }
+
+        if (!$cases) {
+            return '';
+        }
+
+        return "        foreach (\$data as \$key => \$value) {\n            switch (\$key) {\n" . $cases . "            }\n        }\n\n" . $paths;
+    }
+
+    /**
+     * Generate the source of a validator class for the current schema of the validator.
+     *
+     * @param string $class
+     * @param string $namespace
+     * @return string
+     * @throws \InvalidArgumentException
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function generate(string $class, string $namespace = ''): string {
+        $schema = $this->validator->compile();
+
+        if (!$schema->getConditions()->isEmpty()) {
+            throw new InvalidArgumentException('Conditions are closures and cannot be generated');
+        }
+
+        $setup = '';
+        $body = '';
+
+        if (!($this->provider instanceof Constraint)) {
+            $setup .= sprintf("        \$this->addConstraintProvider(new \\%s());\n", get_class($this->provider));
+        }
+
+        // Settings of the schema, so that inherited methods compile the same schema as the generated code
+        if ($schema->getBailMode() !== BailMode::NONE) {
+            $setup .= sprintf("        \$this->setBailMode(\\Titon\\Validate\\BailMode::assert(%s));\n", static::export($schema->getBailMode()));
+        }
+
+        if ($schema->isCostOrdered()) {
+            $costs = Map {};
+
+            foreach ($schema->getFields() as $field) {
+                foreach ($field['rules'] as $rule) {
+                    $costs[$rule['rule']] = $rule['cost'];
+                }
+            }
+
+            foreach ($costs as $rule => $cost) {
+                $setup .= sprintf("        \$this->setConstraintCost(%s, %F);\n", static::export($rule), $cost);
+            }
+
+            $setup .= sprintf("        \$this->setCostOrdering(true, %s);\n", static::export($schema->isCostStrict()));
+        }
+
+        // Caches cannot be shared with generated code, so an equivalent one is created
+        $cache = $schema->getCache();
+
+        if ($cache !== null) {
+            $setup .= sprintf("        \$this->setConstraintCache(new \\Titon\\Validate\\ConstraintCache(%d, %d));\n", $cache->getCapacity(), $cache->getTtl());
+        }
+
+        foreach ($schema->getFields() as $index => $field) {
+            $setup .= sprintf("        \$this->addField(%s, %s);\n", static::export($field['field']), static::export($field['title']));
+
+            if ($field['type'] !== FieldType::MIXED) {
+                $setup .= sprintf("        \$this->setFieldType(%s, \\Titon\\Validate\\FieldType::assert(%s));\n", static::export($field['field']), static::export($field['type']));
+            }
+
+            foreach ($field['rules'] as $rule) {
+                $setup .= sprintf("        \$this->addRule(%s, %s, %s, %s);\n", static::export($field['field']), static::export($rule['rule']), static::export($rule['message']), static::export(new Vector($rule['options'])));
+            }
+
+            if ($schema->getWalkMode() === WalkMode::SCHEMA) {
+                $body .= $this->emitField($schema, $index);
+            }
+        }
+
+        if ($schema->getWalkMode() === WalkMode::DATA) {
+            $body = $this->emitWalk($schema);
+        }
+
+        $source = "<?hh // strict\n/**\n * Generated by Titon\\Validate\\SchemaGenerator, do not modify.\n */\n\n";
+
+        if ($namespace) {
+            $source .= sprintf("namespace %s;\n\n", $namespace);
+        }
+
+        $source .= sprintf("class %s extends \\Titon\\Validate\\CoreValidator {\n\n", $class);
+        $source .= "    public function __construct(\\Titon\\Validate\\DataMap \$data = Map {}) {\n";
+        $source .= "        parent::__construct(\$data);\n\n" . $setup . "    }\n\n";
+        $source .= "    public function validate(\\Titon\\Validate\\DataMap \$data = Map {}): bool {\n";
+        $source .= "        if (\$data) {\n            \$this->setData(\$data);\n        } else if (!\$this->data) {\n            return false;\n        }\n\n";
+        $source .= "        \$schema = \$this->compile();\n\n";
+        $source .= sprintf("        if (\$schema->getRuleCount() !== %d) {\n            return parent::validate();\n        }\n\n", $schema->getRuleCount());
+        $source .= "        \$bits = \$schema->allocateBits();\n        \$rejection = \$schema->reject(\$this->data);\n\n";
+        $source .= "        if (\$rejection === null) {\n            \$this->checkData(\$this->data, \$bits);\n        }\n\n";
+        $source .= "        \$result = (new \\Titon\\Validate\\ValidationResult(\$schema, \$bits, 0, \$rejection))->setCatalog(\$this->catalog);\n";
+        $source .= "        \$this->result = \$result;\n\n        return \$this->addPending(\$result);\n    }\n\n";
+        $source .= "    protected function checkData(\\Titon\\Validate\\DataMap \$data, Vector<int> \$bits): void {\n" . ($body ? rtrim($body) . "\n" : '') . "    }\n\n}\n";
+
+        return $source;
+    }
+
+    /**
+     * Generate the source of a validator class and write it to a file.
+     * Return the number of bytes written.
+     *
+     * @param string $path
+     * @param string $class
+     * @param string $namespace
+     * @return int
+     */
+    public function write(string $path, string $class, string $namespace = ''): int {
+        return (int) file_put_contents($path, $this->generate($class, $namespace));
+    }
+
+    /**
+     * Return the source literal of a value.
+     *
+     * @param mixed $value
+     * @return string
+     * @throws \InvalidArgumentException
+     */
+    public static function export(mixed $value): string {
+        if ($value === null || is_scalar($value)) {
+            return var_export($value, true);
+        }
+
+        if ($value instanceof Indexish) {
+            $items = [];
+            $keyed = ($value instanceof Map || $value instanceof ImmMap || is_array($value));
+
+            foreach ($value as $key => $item) {
+                $items[] = $keyed ? static::export($key) . ' => ' . static::export($item) : static::export($item);
+            }
+
+            if (is_array($value)) {
+                return '[' . implode(', ', $items) . ']';
+            }
+
+            return substr(strrchr('\\' . get_class($value), '\\'), 1) . ' {' . implode(', ', $items) . '}';
+        }
+
+        if ($value instanceof ImmSet || $value instanceof Set) {
+            return substr(strrchr('\\' . get_class($value), '\\'), 1) . ' {' . implode(', ', array_map($item ==> static::export($item), $value->toValuesArray())) . '}';
+        }
+
+        throw new InvalidArgumentException(sprintf('Value of type %s cannot be generated', gettype($value)));
+    }
+
+    /**
+     * Create a generator for a set of shorthand or expanded rule sets.
+     *
+     * @param Map<string, mixed> $fields
+     * @return \Titon\Validate\SchemaGenerator
+     */
+    public static function fromShorthand(Map<string, mixed> $fields): SchemaGenerator {
+        return new static(CoreValidator::makeFromShorthand(Map {}, $fields));
+    }
+
+}
@@ -0,0 +1,318 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * A set of named compiled schemas that validates a single payload against many of them in one pass,
+ * such as every version of an API schema, or every event type a payload may be checked against.
+ *
+ * Rules that share the field, constraint and options across schemas are merged into a single check,
+ * so each distinct check runs once per payload and its outcome is written into the bitset of every schema that defines it.
+ * Conditions, rejections, bail modes, walk modes and the rule order of cost ordering are still applied per schema,
+ * where a wildcard field reports the first rule to fail for its first failing value, so each result reports the same failures
+ * as validating the payload against its schema alone. Since every merged check runs against every value, bailing only
+ * reduces the reported failures, and memoization and scalar variants of the schemas are not used.
+ *
+ * @package Titon\Validate
+ */
+class SchemaSet {
+
+    /**
+     * Distinct checks grouped by field name, so that each field is resolved once per payload.
+     *
+     * @var Map<string, Vector<\Titon\Validate\SchemaCheck>>
+     */
+    protected Map<string, Vector<SchemaCheck>> $checks = Map {};
+
+    /**
+     * Mapping of schema names to their index in the schema list.
+     *
+     * @var ImmMap<string, int>
+     */
+    protected ImmMap<string, int> $index;
+
+    /**
+     * Schema names in the order they were defined.
+     *
+     * @var ImmVector<string>
+     */
+    protected ImmVector<string> $names;
+
+    /**
+     * Number of rules across all schemas.
+     *
+     * @var int
+     */
+    protected int $rules = 0;
+
+    /**
+     * Schemas in the order they were defined.
+     *
+     * @var ImmVector<\Titon\Validate\CompiledSchema>
+     */
+    protected ImmVector<CompiledSchema> $schemas;
+
+    /**
+     * Store the schemas and merge their rules into distinct checks.
+     *
+     * @param Map<string, \Titon\Validate\CompiledSchema> $schemas
+     */
+    public function __construct(Map<string, CompiledSchema> $schemas) {
+        $this->names = $schemas->keys()->toImmVector();
+        $this->schemas = $schemas->values()->toImmVector();
+        $candidates = Map {};
+        $index = Map {};
+
+        foreach ($this->schemas as $s => $schema) {
+            $index[$this->names[$s]] = $s;
+
+            foreach ($schema->getFields() as $f => $compiled) {
+                $field = $compiled['field'];
+                $offset = $schema->getRuleOffset($f);
+
+                if (!$this->checks->contains($field)) {
+                    $this->checks[$field] = Vector {};
+                }
+
+                foreach ($compiled['rules'] as $r => $rule) {
+                    $target = shape('schema' => $s, 'field' => $f, 'bit' => $offset + $r);
+                    $key = $field . '|' . $rule['key'];
+                    $merged = false;
+
+                    // Rules with equal keys may still be bound to different constraints by their validators
+                    foreach (($candidates->get($key) ?: Vector {}) as $c) {
+                        $check = $this->checks[$field][$c];
+
+                        if (static::isSameCheck($check['rule'], $rule)) {
+                            $check['targets'][] = $target;
+                            $merged = true;
+                            break;
+                        }
+                    }
+
+                    if (!$merged) {
+                        if (!$candidates->contains($key)) {
+                            $candidates[$key] = Vector {};
+                        }
+
+                        $candidates[$key][] = $this->checks[$field]->count();
+
+                        $this->checks[$field][] = shape(
+                            'schema' => $s,
+                            'field' => $f,
+                            'rule' => $rule,
+                            'targets' => Vector {$target}
+                        );
+                    }
+
+                    $this->rules++;
+                }
+            }
+        }
+
+        $this->index = $index->toImmMap();
+    }
+
+    /**
+     * Validate the data against the schema named by the value of a key, as for payloads that declare their type or version.
+     * Return null if the key is missing or no schema has that name.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @param string $key
+     * @return \Titon\Validate\ValidationResult
+     */
+    public function dispatch(DataMap $data, string $key = 'type'): ?ValidationResult {
+        $name = $data->get($key);
+
+        if (!is_string($name) && !is_int($name)) {
+            return null;
+        }
+
+        $index = $this->index->get((string) $name);
+
+        if ($index === null) {
+            return null;
+        }
+
+        return $this->schemas[$index]->validate($data);
+    }
+
+    /**
+     * Return the number of distinct checks that are run per payload.
+     *
+     * @return int
+     */
+    public function getCheckCount(): int {
+        $count = 0;
+
+        foreach ($this->checks as $checks) {
+            $count += $checks->count();
+        }
+
+        return $count;
+    }
+
+    /**
+     * Return the names of all schemas.
+     *
+     * @return ImmVector<string>
+     */
+    public function getNames(): ImmVector<string> {
+        return $this->names;
+    }
+
+    /**
+     * Return the number of rules across all schemas, which is the number of checks that would run without merging.
+     *
+     * @return int
+     */
+    public function getRuleCount(): int {
+        return $this->rules;
+    }
+
+    /**
+     * Return a schema by name, or null if it does not exist.
+     *
+     * @param string $name
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function getSchema(string $name): ?CompiledSchema {
+        $index = $this->index->get($name);
+
+        return ($index === null) ? null : $this->schemas[$index];
+    }
+
+    /**
+     * Validate the data against every schema, or only the named schemas, and return a result for each, mapped by schema name.
+     * Checks are only run when at least one of the schemas that defines them applies the field to the data.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @param Traversable<string> $names
+     * @return Map<string, \Titon\Validate\ValidationResult>
+     */
+    public function validate(DataMap $data, ?Traversable<string> $names = null): Map<string, ValidationResult> {
+        $selected = ($names === null) ? null : new Set($names);
+        $active = Vector {};
+        $bits = Vector {};
+        $positions = Vector {};
+        $rejections = Vector {};
+        $states = Vector {};
+
+        foreach ($this->schemas as $s => $schema) {
+            $rejection = null;
+            $include = ($selected === null || $selected->contains($this->names[$s]));
+
+            if ($include) {
+                $rejection = $schema->reject($data);
+            }
+
+            // Merged cross-field rules read the view of the schema they were taken from, which may not be selected
+            $schema->bindRecord($data);
+
+            $active[] = ($include && $rejection === null);
+            $bits[] = $schema->allocateBits();
+            $positions[] = Map {};
+            $rejections[] = $rejection;
+            $states[] = $schema->allocateConditions();
+        }
+
+        foreach ($this->checks as $checks) {
+            $values = null;
+
+            foreach ($checks as $check) {
+                $failed = null;
+                $position = 0;
+
+                foreach ($check['targets'] as $target) {
+                    $s = $target['schema'];
+
+                    if (!$active[$s] || !$this->schemas[$s]->applies($target['field'], $data, $states[$s])) {
+                        continue;
+                    }
+
+                    // The check runs the first time a schema needs it, until the first failing value, whose position is kept for bailing
+                    if ($failed === null) {
+                        if ($values === null) {
+                            $schema = $this->schemas[$check['schema']];
+                            $values = $schema->resolve($schema->getFieldAt($check['field']), $data);
+                        }
+
+                        $failed = false;
+
+                        foreach ($values as $k => $value) {
+                            if (!CompiledSchema::invoke($check['rule'], $value)) {
+                                $failed = true;
+                                $position = $k;
+                                break;
+                            }
+                        }
+                    }
+
+                    if ($failed) {
+                        $bit = $target['bit'];
+                        $bits[$s][$bit >> 6] |= (1 << ($bit & 63));
+
+                        if ($position > 0) {
+                            $positions[$s][$bit] = $position;
+                        }
+                    }
+                }
+            }
+        }
+
+        $results = Map {};
+
+        foreach ($this->schemas as $s => $schema) {
+            $schema->releaseRecord();
+
+            if ($selected !== null && !$selected->contains($this->names[$s])) {
+                continue;
+            }
+
+            if ($active[$s]) {
+                $schema->applyRecordBail($data, $bits[$s], $positions[$s]);
+            }
+
+            $results[$this->names[$s]] = new ValidationResult($schema, $bits[$s], 0, $rejections[$s]);
+        }
+
+        return $results;
+    }
+
+    /**
+     * Create a schema set for named sets of shorthand or expanded rule sets, compiled with the core constraints.
+     *
+     * @param Map<string, Map<string, mixed>> $schemas
+     * @return \Titon\Validate\SchemaSet
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public static function fromShorthand(Map<string, Map<string, mixed>> $schemas): SchemaSet {
+        return new static($schemas->map($fields ==> CoreValidator::compileFromShorthand($fields)));
+    }
+
+    /**
+     * Return true if two rules with equal keys run the same constraint, and can be merged into a single check.
+     * Pattern rules are compared by pattern, since each schema wraps the pattern in its own closure.
+     *
+     * @param \Titon\Validate\CompiledRule $a
+     * @param \Titon\Validate\CompiledRule $b
+     * @return bool
+     */
+    public static function isSameCheck(CompiledRule $a, CompiledRule $b): bool {
+        if ($a['pattern'] !== null || $b['pattern'] !== null) {
+            return ($a['pattern'] === $b['pattern']);
+        }
+
+        if ($a['async'] !== null || $b['async'] !== null) {
+            return ($a['async'] === $b['async']);
+        }
+
+        return ($a['constraint'] === $b['constraint']);
+    }
+
+}
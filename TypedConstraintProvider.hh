@@ -0,0 +1,33 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Declares the types of constraint options, so that options are parsed once when a schema is compiled
+ * instead of being coerced on every call. Constraints can also provide a typed variant,
+ * which is used in place of the original constraint and receives the parsed options.
+ *
+ * @package Titon\Validate
+ */
+interface TypedConstraintProvider {
+
+    /**
+     * Return a map of constraint names to the list of option types, in the order of the options.
+     *
+     * @return Map<string, Vector<\Titon\Validate\OptionType>>
+     */
+    public function getOptionTypes(): Map<string, Vector<OptionType>>;
+
+    /**
+     * Return a map of typed constraint variants, with the key being the rule name.
+     *
+     * @return \Titon\Validate\ConstraintMap
+     */
+    public function getTypedConstraints(): ConstraintMap;
+
+}
@@ -0,0 +1,350 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * The outcome of validating a single data set against a compiled schema.
+ * Failures are stored as a bitset with one bit per schema rule,
+ * while error messages are only rendered once they are read.
+ *
+ * @package Titon\Validate
+ */
+class ValidationResult {
+
+    /**
+     * Word offset of this record within the bitset.
+     *
+     * @var int
+     */
+    protected int $base;
+
+    /**
+     * Failure bitset, possibly shared with other records of a batch.
+     *
+     * @var Vector<int>
+     */
+    protected Vector<int> $bits;
+
+    /**
+     * The message catalog of the locale that messages are rendered in, if not the schema's own messages.
+     *
+     * @var \Titon\Validate\MessageCatalog
+     */
+    protected ?MessageCatalog $catalog = null;
+
+    /**
+     * Rendered error messages, populated as errors are read.
+     *
+     * @var \Titon\Validate\ErrorMap
+     */
+    protected ErrorMap $errors = Map {};
+
+    /**
+     * Mapping of failed fields to the index of the rule that failed, built when first requested.
+     *
+     * @var \Titon\Validate\FailureMap
+     */
+    protected FailureMap $failures = Map {};
+
+    /**
+     * Whether the failure map has been built for the current bitset.
+     *
+     * @var bool
+     */
+    protected bool $resolved = false;
+
+    /**
+     * The reason the data was rejected before any rules were run, if it was.
+     *
+     * @var string
+     */
+    protected ?string $rejection;
+
+    /**
+     * The schema that produced this result.
+     *
+     * @var \Titon\Validate\CompiledSchema
+     */
+    protected CompiledSchema $schema;
+
+    /**
+     * Store the schema, the failure bitset, and the reason the data was rejected.
+     *
+     * @param \Titon\Validate\CompiledSchema $schema
+     * @param Vector<int> $bits
+     * @param int $base
+     * @param string $rejection
+     */
+    public function __construct(CompiledSchema $schema, Vector<int> $bits, int $base = 0, ?string $rejection = null) {
+        $this->schema = $schema;
+        $this->bits = $bits;
+        $this->base = $base;
+        $this->rejection = $rejection;
+    }
+
+    /**
+     * Return the error messages of every failed rule, grouped by field.
+     * Unlike getErrors(), all failures of a field are included, in the order the rules were defined.
+     *
+     * @return Map<string, Vector<string>>
+     * @throws \Titon\Validate\Exception\MissingMessageException
+     */
+    public function getAllErrors(): Map<string, Vector<string>> {
+        $errors = Map {};
+        $schema = $this->schema;
+
+        foreach ($this->getErrorCodes() as $code) {
+            $field = $schema->getFieldAt($code >> 16)['field'];
+
+            if (!$errors->contains($field)) {
+                $errors[$field] = Vector {};
+            }
+
+            $errors[$field][] = $schema->renderCode($code, $this->catalog);
+        }
+
+        return $errors;
+    }
+
+    /**
+     * Return the message catalog that messages are rendered from, or null if the schema's messages are used.
+     *
+     * @return \Titon\Validate\MessageCatalog
+     */
+    public function getCatalog(): ?MessageCatalog {
+        return $this->catalog;
+    }
+
+    /**
+     * Return the error message for a field, or null if the field passed.
+     *
+     * @param string $field
+     * @return string
+     */
+    public function getError(string $field): ?string {
+        $failures = $this->getFailures();
+
+        if (!$failures->contains($field)) {
+            return null;
+        }
+
+        if (!$this->errors->contains($field)) {
+            $this->errors[$field] = $this->schema->renderError($field, $failures[$field], $this->catalog);
+        }
+
+        return $this->errors[$field];
+    }
+
+    /**
+     * Return a packed error code for every failed rule, in the order the rules were defined.
+     * Names and messages are not looked up, use the schema's `renderCode()` or `unpackCode()` when needed.
+     *
+     * @return Vector<int>
+     */
+    public function getErrorCodes(): Vector<int> {
+        $codes = Vector {};
+
+        if ($this->passed()) {
+            return $codes;
+        }
+
+        for ($bit = 0, $count = $this->schema->getRuleCount(); $bit < $count; $bit++) {
+            if ($this->hasFailed($bit)) {
+                $codes[] = $this->schema->getCode($bit);
+            }
+        }
+
+        return $codes;
+    }
+
+    /**
+     * Return all errors. Messages that have not been read yet are rendered.
+     *
+     * @return \Titon\Validate\ErrorMap
+     */
+    public function getErrors(): ErrorMap {
+        $failures = $this->getFailures();
+
+        if ($this->errors->count() !== $failures->count()) {
+            $errors = Map {};
+
+            foreach ($failures as $field => $rule) {
+                $errors[$field] = $this->errors->contains($field) ? $this->errors[$field] : $this->schema->renderError($field, $rule, $this->catalog);
+            }
+
+            $this->errors = $errors;
+        }
+
+        return $this->errors;
+    }
+
+    /**
+     * Return the name of the rule that failed for a field, or null if the field passed.
+     *
+     * @param string $field
+     * @return string
+     */
+    public function getFailedRule(string $field): ?string {
+        $compiled = $this->schema->getField($field);
+        $failures = $this->getFailures();
+
+        if ($compiled === null || !$failures->contains($field)) {
+            return null;
+        }
+
+        return $compiled['rules'][$failures[$field]]['rule'];
+    }
+
+    /**
+     * Return a mapping of failed fields to the index of the rule that failed, without rendering any messages.
+     * When multiple rules of a field failed, the last one is reported.
+     *
+     * @return \Titon\Validate\FailureMap
+     */
+    public function getFailures(): FailureMap {
+        $failures = $this->failures;
+
+        if ($this->resolved) {
+            return $failures;
+        }
+
+        $schema = $this->schema;
+
+        if (!$this->passed()) {
+            for ($bit = 0, $count = $schema->getRuleCount(); $bit < $count; $bit++) {
+                if ($this->hasFailed($bit)) {
+                    $rule = $schema->getRuleAt($bit);
+
+                    $failures[$schema->getFieldAt($rule[0])['field']] = $rule[1];
+                }
+            }
+        }
+
+        $this->resolved = true;
+
+        return $failures;
+    }
+
+    /**
+     * Return the reason the data was rejected before any rules were run, or null if it was not.
+     *
+     * @return string
+     */
+    public function getRejection(): ?string {
+        return $this->rejection;
+    }
+
+    /**
+     * Return the schema that produced this result.
+     *
+     * @return \Titon\Validate\CompiledSchema
+     */
+    public function getSchema(): CompiledSchema {
+        return $this->schema;
+    }
+
+    /**
+     * Return a copy of the words of the failure bitset that belong to this record.
+     *
+     * @return Vector<int>
+     */
+    public function getWords(): Vector<int> {
+        return $this->bits->slice($this->base, $this->schema->getWordCount());
+    }
+
+    /**
+     * Return true if the field failed validation.
+     *
+     * @param string $field
+     * @return bool
+     */
+    public function hasError(string $field): bool {
+        return $this->getFailures()->contains($field);
+    }
+
+    /**
+     * Return true if the rule at the schema wide index failed.
+     *
+     * @param int $bit
+     * @return bool
+     */
+    public function hasFailed(int $bit): bool {
+        return (($this->bits[$this->base + ($bit >> 6)] & (1 << ($bit & 63))) !== 0);
+    }
+
+    /**
+     * Return true if all fields passed validation.
+     *
+     * @return bool
+     */
+    public function passed(): bool {
+        if ($this->rejection !== null) {
+            return false;
+        }
+
+        for ($i = $this->base, $end = $this->base + $this->schema->getWordCount(); $i < $end; $i++) {
+            if ($this->bits[$i] !== 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Validate another data set against the same schema, reusing the bitset and the error storage of this result.
+     * Maps previously returned by this result are cleared, so a result should only be reused once it has been read.
+     * Nothing is allocated for data that passes, unless the schema has conditions.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @return $this
+     */
+    public function revalidate(DataMap $data): this {
+        $bits = $this->bits;
+
+        for ($i = $this->base, $end = $this->base + $this->schema->getWordCount(); $i < $end; $i++) {
+            $bits[$i] = 0;
+        }
+
+        if ($this->resolved) {
+            $this->errors->clear();
+            $this->failures->clear();
+            $this->resolved = false;
+        }
+
+        $this->rejection = $this->schema->check($data, $bits, $this->base);
+
+        return $this;
+    }
+
+    /**
+     * Return true if the data was rejected before any rules were run.
+     *
+     * @return bool
+     */
+    public function rejected(): bool {
+        return ($this->rejection !== null);
+    }
+
+    /**
+     * Render messages from a locale's message catalog, or from the schema's messages when null.
+     * Messages that were already rendered in another locale are discarded.
+     *
+     * @param \Titon\Validate\MessageCatalog $catalog
+     * @return $this
+     */
+    public function setCatalog(?MessageCatalog $catalog): this {
+        if ($catalog !== $this->catalog) {
+            $this->catalog = $catalog;
+            $this->errors = Map {};
+        }
+
+        return $this;
+    }
+
+}
@@ -15,13 +15,15 @@ namespace Titon\Validate;
 interface Validator {
 
     /**
-     * Add a custom constraint.
+     * Add a custom constraint. A pure constraint's result only depends on the value and options,
+     * which allows results to be memoized for repeated values while validating a batch.
      *
      * @param string $key
      * @param \Titon\Validate\ConstraintCallback $callback
+     * @param bool $pure
      * @return $this
      */
-    public function addConstraint(string $key, ConstraintCallback $callback): this;
+    public function addConstraint(string $key, ConstraintCallback $callback, bool $pure = false): this;
 
     /**
      * Load a mapping of constraints defined in a provider.
@@ -31,6 +33,65 @@ interface Validator {
      */
     public function addConstraintProvider(ConstraintProvider $provider): this;
 
+    /**
+     * Add a custom constraint that resolves many values asynchronously in a single call, like a multi-get.
+     * The callback receives a list of distinct values followed by the rule options, and resolves to a list of booleans.
+     * Checks queued by `genValidate()` and `genValidateBatch()` for the same rule and options are coalesced into one call.
+     *
+     * @param string $key
+     * @param \Titon\Validate\AsyncBulkConstraintCallback $callback
+     * @return $this
+     */
+    public function addAsyncBulkConstraint(string $key, AsyncBulkConstraintCallback $callback): this;
+
+    /**
+     * Add a custom constraint that resolves asynchronously, like a database or cache lookup.
+     * Async constraints are run concurrently by `genValidate()`, and are blocked on by `validate()`.
+     *
+     * @param string $key
+     * @param \Titon\Validate\AsyncConstraintCallback $callback
+     * @return $this
+     */
+    public function addAsyncConstraint(string $key, AsyncConstraintCallback $callback): this;
+
+    /**
+     * Add a bulk variant of an existing constraint, which validates a whole column of values in a single call.
+     * The callback receives a list of values followed by the rule options, and returns a list of booleans.
+     *
+     * @param string $key
+     * @param \Titon\Validate\BulkConstraintCallback $callback
+     * @return $this
+     */
+    public function addBulkConstraint(string $key, BulkConstraintCallback $callback): this;
+
+    /**
+     * Add a condition that decides whether a group of fields applies to a record. The predicate receives the record
+     * and is evaluated at most once per record, and the rules of the fields are skipped entirely when it returns false.
+     * Conditions can be nested within a previously added parent condition, which has to apply first.
+     * The keys are the top level keys of the record that the predicate reads. When none are defined,
+     * the fields of the condition are re-validated on every change by `validateChanged()`.
+     *
+     * @param string $name
+     * @param \Titon\Validate\ConditionCallback $predicate
+     * @param Vector<string> $fields
+     * @param string $parent
+     * @param Vector<string> $keys
+     * @return $this
+     */
+    public function addCondition(string $name, ConditionCallback $predicate, Vector<string> $fields, string $parent = '', Vector<string> $keys = Vector {}): this;
+
+    /**
+     * Add a constraint that compares a value to other fields of the same record. The callback receives the value,
+     * a read-only view of the record, and the rule's options, where the defined number of leading options
+     * name the referenced fields. Fields are re-validated by `validateChanged()` when a field they reference changes.
+     *
+     * @param string $key
+     * @param \Titon\Validate\CrossConstraintCallback $callback
+     * @param int $references
+     * @return $this
+     */
+    public function addCrossConstraint(string $key, CrossConstraintCallback $callback, int $references = 1): this;
+
     /**
      * Mark a field has an error.
      *
@@ -42,6 +103,7 @@ interface Validator {
 
     /**
      * Add a field to be used in validation. Can optionally apply an array of validation rules.
+     * The field can be a dot notated path into nested data, like "address.city", where "*" matches every item, like "items.*.sku".
      *
      * @param string $field
      * @param string $title
@@ -69,6 +131,103 @@ interface Validator {
      */
     public function addRule(string $field, string $rule, string $message, OptionList $options = Vector{}): this;
 
+    /**
+     * Add a variant of an existing constraint that is only called with values of a scalar type,
+     * for fields that declare the type.
+     *
+     * @param string $key
+     * @param \Titon\Validate\FieldType $type
+     * @param \Titon\Validate\ConstraintCallback $callback
+     * @return $this
+     */
+    public function addScalarConstraint(string $key, FieldType $type, ConstraintCallback $callback): this;
+
+    /**
+     * Declare the types of an existing constraint's options, so that they are parsed once at compile time.
+     * An optional typed variant replaces the constraint and receives the parsed options.
+     *
+     * @param string $key
+     * @param Vector<\Titon\Validate\OptionType> $types
+     * @param \Titon\Validate\ConstraintCallback $callback
+     * @return $this
+     */
+    public function addTypedConstraint(string $key, Vector<OptionType> $types, ?ConstraintCallback $callback = null): this;
+
+    /**
+     * Freeze the current fields, rules, constraints and messages into an immutable schema.
+     * Every rule is bound to its constraint, so a missing constraint is reported for all fields, not only those in the data.
+     *
+     * @return \Titon\Validate\CompiledSchema
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function compile(): CompiledSchema;
+
+    /**
+     * Validate the data against the rules schema while running async constraints concurrently.
+     * Resolves to true if all fields passed validation.
+     *
+     * @param \Titon\Validate\DataMap $data
+     * @return Awaitable<bool>
+     */
+    public function genValidate(DataMap $data = Map {}): Awaitable<bool>;
+
+    /**
+     * Validate many records against the rules schema while running and coalescing async constraints concurrently.
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return Awaitable<\Titon\Validate\BatchResult>
+     */
+    public function genValidateBatch(Traversable<DataMap> $records): Awaitable<BatchResult>;
+
+    /**
+     * Return a map of async bulk constraint callbacks with the key being the rule name.
+     *
+     * @return \Titon\Validate\AsyncBulkConstraintMap
+     */
+    public function getAsyncBulkConstraints(): AsyncBulkConstraintMap;
+
+    /**
+     * Return a map of async constraint callbacks with the key being the rule name.
+     *
+     * @return \Titon\Validate\AsyncConstraintMap
+     */
+    public function getAsyncConstraints(): AsyncConstraintMap;
+
+    /**
+     * Return the bail mode used during validation.
+     *
+     * @return \Titon\Validate\BailMode
+     */
+    public function getBailMode(): BailMode;
+
+    /**
+     * Return a map of bulk constraint callbacks with the key being the rule name.
+     *
+     * @return \Titon\Validate\BulkConstraintMap
+     */
+    public function getBulkConstraints(): BulkConstraintMap;
+
+    /**
+     * Return the conditions.
+     *
+     * @return \Titon\Validate\ConditionMap
+     */
+    public function getConditions(): ConditionMap;
+
+    /**
+     * Return the cache used for async constraint results.
+     *
+     * @return \Titon\Validate\ConstraintCache
+     */
+    public function getConstraintCache(): ?ConstraintCache;
+
+    /**
+     * Return the estimated cost of constraints in microseconds per call, mapped by rule name.
+     *
+     * @return Map<string, float>
+     */
+    public function getConstraintCosts(): Map<string, float>;
+
     /**
      * Return a map of constraint callbacks with the key being the rule name.
      *
@@ -76,6 +235,13 @@ interface Validator {
      */
     public function getConstraints(): ConstraintMap;
 
+    /**
+     * Return the cross-field constraints.
+     *
+     * @return \Titon\Validate\CrossConstraintMap
+     */
+    public function getCrossConstraints(): CrossConstraintMap;
+
     /**
      * Return the currently set data.
      *
@@ -90,6 +256,13 @@ interface Validator {
      */
     public function getErrors(): ErrorMap;
 
+    /**
+     * Return a mapping of fields and the name of the condition they belong to.
+     *
+     * @return Map<string, string>
+     */
+    public function getFieldConditions(): Map<string, string>;
+
     /**
      * Return the fields.
      *
@@ -97,6 +270,27 @@ interface Validator {
      */
     public function getFields(): FieldMap;
 
+    /**
+     * Return the mapping of fields and the scalar type of their values.
+     *
+     * @return Map<string, \Titon\Validate\FieldType>
+     */
+    public function getFieldTypes(): Map<string, FieldType>;
+
+    /**
+     * Return the instrumentation collector, if enabled.
+     *
+     * @return \Titon\Validate\Instrumentation
+     */
+    public function getInstrumentation(): ?Instrumentation;
+
+    /**
+     * Return the message catalog that errors are rendered from, or null if the messages of the validator are used.
+     *
+     * @return \Titon\Validate\MessageCatalog
+     */
+    public function getMessageCatalog(): ?MessageCatalog;
+
     /**
      * Return the messages.
      *
@@ -104,6 +298,35 @@ interface Validator {
      */
     public function getMessages(): MessageMap;
 
+    /**
+     * Return a map of constraints to the types of their options.
+     *
+     * @return Map<string, Vector<\Titon\Validate\OptionType>>
+     */
+    public function getOptionTypes(): Map<string, Vector<OptionType>>;
+
+    /**
+     * Return a map of pattern constraints to the index of the option that holds the pattern.
+     *
+     * @return Map<string, int>
+     */
+    public function getPatternConstraints(): Map<string, int>;
+
+    /**
+     * Return the names of constraints that are pure.
+     *
+     * @return Set<string>
+     */
+    public function getPureConstraints(): Set<string>;
+
+    /**
+     * Return the result of the last validation, or null if nothing has been validated since the last reset.
+     * The result exposes every failure as a packed (field index, rule index) error code.
+     *
+     * @return \Titon\Validate\ValidationResult
+     */
+    public function getResult(): ?ValidationResult;
+
     /**
      * Return the rules.
      *
@@ -111,6 +334,49 @@ interface Validator {
      */
     public function getRules(): RuleContainer;
 
+    /**
+     * Return the scalar constraint variants.
+     *
+     * @return \Titon\Validate\ScalarConstraintMap
+     */
+    public function getScalarConstraints(): ScalarConstraintMap;
+
+    /**
+     * Return the typed constraint variants.
+     *
+     * @return \Titon\Validate\ConstraintMap
+     */
+    public function getTypedConstraints(): ConstraintMap;
+
+    /**
+     * Return true if the rules of a field run cheapest first when a bail mode is set.
+     *
+     * @return bool
+     */
+    public function isCostOrdered(): bool;
+
+    /**
+     * Return true if cost ordering reports the same rule as the definition order.
+     *
+     * @return bool
+     */
+    public function isCostStrict(): bool;
+
+    /**
+     * Return true if the result and error storage are reused across validations.
+     *
+     * @return bool
+     */
+    public function isPooled(): bool;
+
+    /**
+     * Merge the costs learned by an instrumentation collector into the estimated cost of constraints.
+     *
+     * @param \Titon\Validate\Instrumentation $instrumentation
+     * @return $this
+     */
+    public function learnCosts(Instrumentation $instrumentation): this;
+
     /**
      * Reset the state of the validator.
      *
@@ -118,6 +384,40 @@ interface Validator {
      */
     public function reset(): this;
 
+    /**
+     * Set when validation should stop after a rule fails.
+     *
+     * @param \Titon\Validate\BailMode $mode
+     * @return $this
+     */
+    public function setBailMode(BailMode $mode): this;
+
+    /**
+     * Set the cache used for async constraint results. The cache can be shared between validators.
+     *
+     * @param \Titon\Validate\ConstraintCache $cache
+     * @return $this
+     */
+    public function setConstraintCache(?ConstraintCache $cache): this;
+
+    /**
+     * Set the estimated cost of a constraint, in microseconds per call.
+     *
+     * @param string $key
+     * @param float $cost
+     * @return $this
+     */
+    public function setConstraintCost(string $key, float $cost): this;
+
+    /**
+     * Set whether the rules of a field run cheapest first when a bail mode is set.
+     *
+     * @param bool $ordering
+     * @param bool $strict
+     * @return $this
+     */
+    public function setCostOrdering(bool $ordering, bool $strict = true): this;
+
     /**
      * Set the data to validate against.
      *
@@ -126,12 +426,92 @@ interface Validator {
      */
     public function setData(DataMap $data): this;
 
+    /**
+     * Declare the scalar type of a field's values. Values of the type are validated with the scalar variants
+     * of the field's constraints, while values of other types are validated with the original constraints.
+     *
+     * @param string $field
+     * @param \Titon\Validate\FieldType $type
+     * @return $this
+     */
+    public function setFieldType(string $field, FieldType $type): this;
+
+    /**
+     * Report timing and failure counters of schema builds, constraint calls and message rendering to a collector.
+     * The name defaults to the validator's class name. Passing null disables instrumentation.
+     *
+     * @param \Titon\Validate\Instrumentation $instrumentation
+     * @param string $name
+     * @return $this
+     */
+    public function setInstrumentation(?Instrumentation $instrumentation, string $name = ''): this;
+
+    /**
+     * Set the message catalog of the locale that errors are rendered in, or null to use the messages of the validator.
+     * Rules without a message in the catalog fall back to their own message. Errors that were already rendered are kept.
+     *
+     * @param \Titon\Validate\MessageCatalog $catalog
+     * @return $this
+     */
+    public function setMessageCatalog(?MessageCatalog $catalog): this;
+
+    /**
+     * Set whether the result and error storage are reused across validations, as done by a validator pool.
+     * When pooled, the result returned by getResult() is refilled by the next validation, so it must not be kept.
+     *
+     * @param bool $pooled
+     * @return $this
+     */
+    public function setPooled(bool $pooled): this;
+
     /**
      * Validate the data against the rules schema. Return true if all fields passed validation.
      *
+     * The schema is compiled before any data is read, so a rule without a constraint throws
+     * even when its field is missing from the data.
+     *
      * @param \Titon\Validate\DataMap $data
      * @return bool
+     * @throws \Titon\Validate\Exception\MissingConstraintException
      */
     public function validate(DataMap $data = Map {}): bool;
 
+    /**
+     * Validate many records against the rules schema and return a compact result for all of them.
+     * The validator's data and errors are left untouched.
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return \Titon\Validate\BatchResult
+     */
+    public function validateBatch(Traversable<DataMap> $records): BatchResult;
+
+    /**
+     * Merge changed values into a copy of the data and re-validate only the fields they affect, which are the fields
+     * of the changed keys and the fields whose conditions read them. The errors of those fields are replaced,
+     * while the errors of all other fields are kept from the previous validation.
+     * The whole data is validated when it has not been validated before, or when bailing on the first failure.
+     *
+     * @param \Titon\Validate\DataMap $delta
+     * @return bool
+     */
+    public function validateChanged(DataMap $delta): bool;
+
+    /**
+     * Validate many records column by column, running each rule across all values of a field before the next rule.
+     * Returns the same result as validateBatch(), but makes use of bulk constraints.
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return \Titon\Validate\BatchResult
+     */
+    public function validateColumns(Traversable<DataMap> $records): BatchResult;
+
+    /**
+     * Validate records one at a time as they are read, and yield a result for each.
+     * Records can come from any generator, such as an `NdjsonReader`, and are never materialized at once.
+     *
+     * @param Traversable<\Titon\Validate\DataMap> $records
+     * @return Iterator<\Titon\Validate\ValidationResult>
+     */
+    public function validateStream(Traversable<DataMap> $records): Iterator<ValidationResult>;
+
 }
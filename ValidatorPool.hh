@@ -0,0 +1,154 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * A pool of validators that are reused across requests by a single worker.
+ * Validators are created by a factory, switched into pooled mode, and reset when released,
+ * so that their compiled schema, scratch result and error storage survive between checkouts.
+ * After the first validation of each validator, validating data that passes allocates nothing.
+ *
+ * The pool is not shared between processes, so a long running worker should hold a pool for its lifetime.
+ *
+ * @package Titon\Validate
+ */
+class ValidatorPool {
+
+    /**
+     * Number of validators created by the factory.
+     *
+     * @var int
+     */
+    protected int $created = 0;
+
+    /**
+     * Factory that creates a new validator with its fields and rules defined.
+     *
+     * @var (function(): \Titon\Validate\Validator)
+     */
+    protected (function(): Validator) $factory;
+
+    /**
+     * Validators that are ready to be checked out.
+     *
+     * @var Vector<\Titon\Validate\Validator>
+     */
+    protected Vector<Validator> $idle = Vector {};
+
+    /**
+     * Maximum number of idle validators to keep. Validators released beyond the limit are discarded.
+     *
+     * @var int
+     */
+    protected int $limit;
+
+    /**
+     * Store the factory and the maximum number of idle validators.
+     *
+     * @param (function(): \Titon\Validate\Validator) $factory
+     * @param int $limit
+     */
+    public function __construct((function(): Validator) $factory, int $limit = 16) {
+        $this->factory = $factory;
+        $this->limit = max($limit, 1);
+    }
+
+    /**
+     * Return an idle validator, or create one when none are idle.
+     *
+     * @return \Titon\Validate\Validator
+     */
+    public function checkout(): Validator {
+        if (!$this->idle->isEmpty()) {
+            return $this->idle->pop();
+        }
+
+        return $this->create();
+    }
+
+    /**
+     * Create a new validator in pooled mode.
+     *
+     * @return \Titon\Validate\Validator
+     */
+    protected function create(): Validator {
+        $factory = $this->factory;
+
+        $this->created++;
+
+        return $factory()->setPooled(true);
+    }
+
+    /**
+     * Return the number of validators created by the factory.
+     *
+     * @return int
+     */
+    public function getCreated(): int {
+        return $this->created;
+    }
+
+    /**
+     * Return the number of idle validators.
+     *
+     * @return int
+     */
+    public function getIdleCount(): int {
+        return $this->idle->count();
+    }
+
+    /**
+     * Create validators until the defined number are idle, and compile their schemas,
+     * so that the first requests do not pay for building them.
+     *
+     * @param int $count
+     * @return $this
+     * @throws \Titon\Validate\Exception\MissingConstraintException
+     */
+    public function prime(int $count): this {
+        $count = min($count, $this->limit);
+
+        while ($this->idle->count() < $count) {
+            $validator = $this->create();
+            $validator->compile();
+
+            $this->idle[] = $validator;
+        }
+
+        return $this;
+    }
+
+    /**
+     * Reset a validator and return it to the pool.
+     *
+     * @param \Titon\Validate\Validator $validator
+     */
+    public function release(Validator $validator): void {
+        if ($this->idle->count() < $this->limit) {
+            $this->idle[] = $validator->reset();
+        }
+    }
+
+    /**
+     * Check out a validator, pass it to the callback, and release it once the callback returns or throws.
+     * Return the value returned by the callback.
+     *
+     * @param (function(\Titon\Validate\Validator): T) $callback
+     * @return T
+     */
+    public function using<T>((function(Validator): T) $callback): T {
+        $validator = $this->checkout();
+
+        try {
+            return $callback($validator);
+        } finally {
+            $this->release($validator);
+        }
+    }
+
+}
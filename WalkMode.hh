@@ -0,0 +1,21 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate;
+
+/**
+ * Determines what is iterated during validation.
+ *
+ *  SCHEMA  - Walk the compiled fields and look up only those keys in the data (default)
+ *  DATA    - Walk every key in the data and look up its compiled field
+ *
+ * @package Titon\Validate
+ */
+enum WalkMode : int {
+    SCHEMA = 0;
+    DATA = 1;
+}
@@ -0,0 +1,159 @@
+<?hh // strict
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+namespace Titon\Validate\Bench;
+
+type BenchScenario = shape('name' => string, 'operation' => (function(): void), 'iterations' => int, 'records' => int);
+type BenchReport = shape('name' => string, 'iterations' => int, 'records' => int, 'ops' => float, 'records_per_sec' => float, 'p50_us' => float, 'p99_us' => float, 'bytes_per_op' => int, 'peak_bytes' => int);
+
+/**
+ * A minimal benchmark harness. Every scenario is warmed up so that the JIT has compiled the hot paths,
+ * then each operation is timed individually to report throughput and latency percentiles.
+ *
+ * HHVM does not expose allocation counts, so memory is reported as the bytes retained per operation
+ * and the peak usage of the process after the scenario ran.
+ *
+ * @package Titon\Validate\Bench
+ */
+class Benchmark {
+
+    /**
+     * Scenarios in the order they were added.
+     *
+     * @var Vector<\Titon\Validate\Bench\BenchScenario>
+     */
+    protected Vector<BenchScenario> $scenarios = Vector {};
+
+    /**
+     * Number of untimed iterations run before measuring, as a fraction of the timed iterations.
+     *
+     * @var float
+     */
+    protected float $warmup;
+
+    /**
+     * Store the warmup ratio.
+     *
+     * @param float $warmup
+     */
+    public function __construct(float $warmup = 0.1) {
+        $this->warmup = $warmup;
+    }
+
+    /**
+     * Add a scenario. The number of records is the amount of data sets a single operation validates.
+     *
+     * @param string $name
+     * @param (function(): void) $operation
+     * @param int $iterations
+     * @param int $records
+     * @return $this
+     */
+    public function add(string $name, (function(): void) $operation, int $iterations, int $records = 1): this {
+        $this->scenarios[] = shape(
+            'name' => $name,
+            'operation' => $operation,
+            'iterations' => max($iterations, 1),
+            'records' => $records
+        );
+
+        return $this;
+    }
+
+    /**
+     * Return the names of all scenarios.
+     *
+     * @return Vector<string>
+     */
+    public function getNames(): Vector<string> {
+        return $this->scenarios->map($scenario ==> $scenario['name']);
+    }
+
+    /**
+     * Run all scenarios whose name matches the filter, and return a report for each.
+     *
+     * @param string $filter
+     * @return Vector<\Titon\Validate\Bench\BenchReport>
+     */
+    public function run(string $filter = ''): Vector<BenchReport> {
+        $reports = Vector {};
+
+        foreach ($this->scenarios as $scenario) {
+            if ($filter === '' || strpos($scenario['name'], $filter) !== false) {
+                $reports[] = $this->runScenario($scenario);
+            }
+        }
+
+        return $reports;
+    }
+
+    /**
+     * Warm up and measure a single scenario.
+     *
+     * @param \Titon\Validate\Bench\BenchScenario $scenario
+     * @return \Titon\Validate\Bench\BenchReport
+     */
+    protected function runScenario(BenchScenario $scenario): BenchReport {
+        $operation = $scenario['operation'];
+        $iterations = $scenario['iterations'];
+
+        for ($i = 0, $warmup = (int) ceil($iterations * $this->warmup); $i < $warmup; $i++) {
+            $operation();
+        }
+
+        gc_collect_cycles();
+
+        $samples = Vector {};
+        $samples->reserve($iterations);
+        $memory = memory_get_usage();
+        $total = 0.0;
+
+        for ($i = 0; $i < $iterations; $i++) {
+            $start = microtime(true);
+            $operation();
+            $elapsed = microtime(true) - $start;
+
+            $samples[] = $elapsed;
+            $total += $elapsed;
+        }
+
+        $retained = memory_get_usage() - $memory;
+        $sorted = $samples->toArray();
+        sort($sorted);
+        $total = max($total, 1e-9);
+
+        return shape(
+            'name' => $scenario['name'],
+            'iterations' => $iterations,
+            'records' => $scenario['records'],
+            'ops' => round($iterations / $total, 2),
+            'records_per_sec' => round(($iterations * $scenario['records']) / $total, 2),
+            'p50_us' => round(static::percentile($sorted, 0.50) * 1000000, 3),
+            'p99_us' => round(static::percentile($sorted, 0.99) * 1000000, 3),
+            'bytes_per_op' => (int) round(max($retained, 0) / $iterations),
+            'peak_bytes' => memory_get_peak_usage()
+        );
+    }
+
+    /**
+     * Return the value at a percentile of a sorted list of samples, using the nearest rank.
+     *
+     * @param array<float> $sorted
+     * @param float $percentile
+     * @return float
+     */
+    public static function percentile(array<float> $sorted, float $percentile): float {
+        if (!$sorted) {
+            return 0.0;
+        }
+
+        $rank = (int) ceil($percentile * count($sorted)) - 1;
+
+        return $sorted[min(max($rank, 0), count($sorted) - 1)];
+    }
+
+}
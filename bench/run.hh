@@ -0,0 +1,214 @@
+<?hh
+/**
+ * @copyright   2010-2015, The Titon Project
+ * @license     http://opensource.org/licenses/bsd-license.php
+ * @link        http://titon.io
+ */
+
+/**
+ * Benchmarks for the validation engines.
+ *
+ *  hhvm bench/run.hh [--filter=name] [--iterations=10000] [--rows=1000000] [--format=json|table]
+ *
+ * The JSON format writes one object per scenario and line with stable keys, for regression tracking.
+ */
+
+namespace Titon\Validate\Bench;
+
+use Titon\Validate\AbstractValidator;
+use Titon\Validate\BailMode;
+use Titon\Validate\Constraint;
+use Titon\Validate\ConstraintRegistry;
+use Titon\Validate\CoreValidator;
+use Titon\Validate\FieldType;
+use Titon\Validate\MessageCatalog;
+use Titon\Validate\SchemaGenerator;
+use Titon\Validate\SchemaSet;
+use Titon\Validate\ValidatorPool;
+use Titon\Validate\WalkMode;
+
+require_once dirname(__DIR__) . '/vendor/autoload.php';
+require_once __DIR__ . '/Benchmark.hh';
+
+$options = getopt('', ['filter:', 'iterations:', 'rows:', 'format:']);
+$iterations = (int) idx($options, 'iterations', 10000);
+$rows = (int) idx($options, 'rows', 1000000);
+$format = (string) idx($options, 'format', 'json');
+
+// Schemas
+
+$small = Map {
+    'username' => 'notEmpty:Username is required|alphaNumeric:Username must be alphanumeric|between:3,20:Username must be between {0} and {1} characters',
+    'email' => 'notEmpty:Email is required|email:false:Email is invalid',
+    'age' => 'numeric:Age must be a number|inRange:18,120:Age must be between {0} and {1}',
+    'role' => 'inList:admin,editor,author,reader:Role is invalid',
+    'website' => 'url:Website is invalid'
+};
+
+$typed = Map {
+    'username' => Map {'rules' => $small['username'], 'type' => FieldType::STRING},
+    'email' => $small['email'],
+    'age' => Map {'rules' => $small['age'], 'type' => FieldType::INT},
+    'role' => Map {'rules' => $small['role'], 'type' => FieldType::STRING},
+    'website' => $small['website']
+};
+
+$versions = Map {'v1' => $small, 'v2' => new Map($small), 'v3' => new Map($small)};
+$versions['v2']['nickname'] = 'maxLength:30:Nickname is too long';
+$versions['v3']['role'] = 'inList:admin,editor,author,reader,guest:Role is invalid';
+
+$wide = Map {};
+
+for ($i = 0; $i < 200; $i++) {
+    $wide['field' . $i] = 'notEmpty:Field {title} is required|maxLength:50:Field {title} is too long';
+}
+
+$nested = Map {
+    'user.profile.address.city' => 'notEmpty:City is required|maxLength:50:City is too long',
+    'items.*.sku' => 'alphaNumeric:SKU must be alphanumeric|minLength:4:SKU is too short',
+    'items.*.quantity' => 'numeric:Quantity must be a number|inRange:1,99:Quantity must be between {0} and {1}'
+};
+
+// Data
+
+$smallPass = Map {'username' => 'titon', 'email' => 'titon@example.com', 'age' => 30, 'role' => 'editor', 'website' => 'http://titon.io'};
+$smallFail = Map {'username' => '', 'email' => 'invalid', 'age' => 'old', 'role' => 'owner', 'website' => 'nope'};
+$smallOversized = Map {'username' => str_repeat('a', 1048576), 'email' => str_repeat('a', 1048576) . '@example.com', 'age' => 30, 'role' => 'editor', 'website' => 'http://titon.io'};
+$widePass = Map {};
+$wideFail = Map {};
+
+for ($i = 0; $i < 200; $i++) {
+    $widePass['field' . $i] = 'value' . $i;
+    $wideFail['field' . $i] = '';
+}
+
+$items = Vector {};
+
+for ($i = 0; $i < 50; $i++) {
+    $items[] = Map {'sku' => 'SKU' . $i . 'X', 'quantity' => ($i % 98) + 1};
+}
+
+$nestedData = Map {
+    'user' => Map {'profile' => Map {'address' => Map {'city' => 'Los Angeles'}}},
+    'items' => $items
+};
+
+// The first item fails a later rule than the second item, so bailing has to stop at the first failed value
+$nestedFail = Map {
+    'user' => Map {'profile' => Map {'address' => Map {'city' => ''}}},
+    'items' => Vector {Map {'sku' => 'AB', 'quantity' => 5}, Map {'sku' => 'A-B-C', 'quantity' => 500}}
+};
+
+$records = function(int $count) use ($smallPass, $smallFail): Iterator<Map<string, mixed>> {
+    for ($i = 0; $i < $count; $i++) {
+        yield ($i % 10 === 0) ? $smallFail : $smallPass;
+    }
+};
+
+// Engines
+
+$core = CoreValidator::makeFromShorthand(Map {}, $small);
+$schema = CoreValidator::compileFromShorthand($small);
+$wideSchema = CoreValidator::compileFromShorthand($wide);
+$nestedSchema = CoreValidator::compileFromShorthand($nested);
+$bailSchema = $schema->withBailMode(BailMode::FIELD);
+$limitedSchema = $schema->withMaxStringLength(1024)->withMaxCollectionSize(100)->withMaxDepth(8);
+$typedSchema = CoreValidator::compileFromShorthand($typed);
+$catalog = MessageCatalog::load('de', () ==> Map {'between' => '{title} muss zwischen {0} und {1} Zeichen lang sein'});
+$set = SchemaSet::fromShorthand($versions);
+$versionSchemas = $versions->map($fields ==> CoreValidator::compileFromShorthand($fields));
+$pool = (new ValidatorPool(() ==> CoreValidator::makeFromShorthand(Map {}, $small)))->prime(1);
+
+eval(substr((new SchemaGenerator($core))->generate('GeneratedSmallValidator', __NAMESPACE__), strlen('<?hh // strict')));
+$generated = new GeneratedSmallValidator();
+
+// Engines that promise the same failures are compared once, so that no numbers are reported for an engine that diverges
+
+$verify = (string $name, Vector<int> $expected, Vector<int> $actual) ==> {
+    if ($expected->toArray() !== $actual->toArray()) {
+        fwrite(STDERR, sprintf("Engine %s does not report the same failures\n", $name));
+        exit(1);
+    }
+};
+
+$nestedRecords = Vector {$nestedData, $nestedFail, $nestedFail->toMap()->setAll(Map {'items' => $items})};
+
+$modes = Map {
+    'none' => $nestedSchema,
+    'field' => $nestedSchema->withBailMode(BailMode::FIELD),
+    'field.ordered' => $nestedSchema->withBailMode(BailMode::FIELD)->withCostOrdering(true, false),
+    'all' => $nestedSchema->withBailMode(BailMode::ALL),
+    'all.walked' => $nestedSchema->withBailMode(BailMode::ALL)->withWalkMode(WalkMode::DATA)
+};
+$modeSet = new SchemaSet($modes);
+
+foreach ($modes as $name => $modeSchema) {
+    $verify('columns.nested.' . $name, $modeSchema->validateBatch($nestedRecords)->getBits(), $modeSchema->validateColumns($nestedRecords)->getBits());
+}
+
+foreach ($nestedRecords as $record) {
+    $results = $modeSet->validate($record);
+
+    foreach ($modes as $name => $modeSchema) {
+        $verify('set.nested.' . $name, $modeSchema->validate($record)->getWords(), $results[$name]->getWords());
+    }
+}
+
+// Scenarios
+
+$bench = new Benchmark();
+
+$bench
+    ->add('construct.getConstraints.cold', () ==> {
+        ConstraintRegistry::flush();
+        (new Constraint())->getConstraints();
+    }, (int) ceil($iterations / 10))
+    ->add('construct.getConstraints.warm', () ==> { (new Constraint())->getConstraints(); }, $iterations)
+    ->add('construct.splitShorthand', () ==> { AbstractValidator::splitShorthand('between:3,20:Username must be between {0} and {1} characters'); }, $iterations)
+    ->add('construct.makeFromShorthand.small', () ==> { CoreValidator::makeFromShorthand(Map {}, $small); }, $iterations)
+    ->add('construct.compile.small', () ==> { CoreValidator::compileFromShorthand($small); }, $iterations)
+    ->add('construct.compile.wide', () ==> { CoreValidator::compileFromShorthand($wide); }, (int) ceil($iterations / 100))
+    ->add('message.formatMessage', () ==> { $core->formatMessage('username', shape('rule' => 'between', 'message' => 'Username must be between {0} and {1} characters', 'options' => Vector {3, 20})); }, $iterations)
+    ->add('message.renderError', () ==> { $schema->renderError('username', 2); }, $iterations)
+    ->add('message.renderError.catalog', () ==> { $schema->renderError('username', 2, $catalog); }, $iterations)
+    ->add('core.small.pass', () ==> { $core->reset()->validate($smallPass); }, $iterations)
+    ->add('core.small.fail', () ==> { $core->reset()->validate($smallFail); $core->getErrors(); }, $iterations)
+    ->add('pooled.small.pass', () ==> { $pool->using($validator ==> $validator->validate($smallPass)); }, $iterations)
+    ->add('pooled.small.fail', () ==> { $pool->using($validator ==> { $validator->validate($smallFail); return $validator->getErrors(); }); }, $iterations)
+    ->add('generated.small.pass', () ==> { $generated->reset()->validate($smallPass); }, $iterations)
+    ->add('generated.small.fail', () ==> { $generated->reset()->validate($smallFail); $generated->getErrors(); }, $iterations)
+    ->add('schema.small.pass', () ==> { $schema->validate($smallPass)->passed(); }, $iterations)
+    ->add('schema.small.fail', () ==> { $schema->validate($smallFail)->getErrors(); }, $iterations)
+    ->add('schema.small.fail.codes', () ==> { $schema->validate($smallFail)->getErrorCodes(); }, $iterations)
+    ->add('schema.small.oversized', () ==> { $schema->validate($smallOversized)->passed(); }, (int) ceil($iterations / 100))
+    ->add('schema.small.oversized.limited', () ==> { $limitedSchema->validate($smallOversized)->passed(); }, (int) ceil($iterations / 100))
+    ->add('schema.small.pass.limited', () ==> { $limitedSchema->validate($smallPass)->passed(); }, $iterations)
+    ->add('schema.small.pass.typed', () ==> { $typedSchema->validate($smallPass)->passed(); }, $iterations)
+    ->add('schema.small.fail.bail', () ==> { $bailSchema->validate($smallFail)->getErrors(); }, $iterations)
+    ->add('set.versions.pass', () ==> { $set->validate($smallPass); }, $iterations)
+    ->add('set.versions.fail', () ==> { $set->validate($smallFail); }, $iterations)
+    ->add('set.versions.separate', () ==> { foreach ($versionSchemas as $versionSchema) { $versionSchema->validate($smallFail); } }, $iterations)
+    ->add('schema.wide.pass', () ==> { $wideSchema->validate($widePass)->passed(); }, (int) ceil($iterations / 10))
+    ->add('schema.wide.fail', () ==> { $wideSchema->validate($wideFail)->getErrors(); }, (int) ceil($iterations / 10))
+    ->add('schema.nested', () ==> { $nestedSchema->validate($nestedData)->passed(); }, (int) ceil($iterations / 10))
+    ->add('batch.rows', () ==> { $schema->validateBatch($records($rows))->passed(); }, 1, $rows)
+    ->add('batch.columns', () ==> { $schema->validateColumns($records($rows))->passed(); }, 1, $rows)
+    ->add('batch.columns.wildcard', () ==> { $nestedSchema->withBailMode(BailMode::FIELD)->validateColumns($nestedRecords)->passed(); }, (int) ceil($iterations / 10), $nestedRecords->count())
+    ->add('batch.stream', () ==> { foreach ($schema->validateStream($records($rows)) as $result) { $result->passed(); } }, 1, $rows);
+
+$reports = $bench->run((string) idx($options, 'filter', ''));
+
+// Output
+
+if ($format === 'table') {
+    printf("%-36s %14s %16s %12s %12s %14s\n", 'scenario', 'ops/sec', 'records/sec', 'p50 (us)', 'p99 (us)', 'bytes/op');
+
+    foreach ($reports as $report) {
+        printf("%-36s %14.2f %16.2f %12.3f %12.3f %14d\n", $report['name'], $report['ops'], $report['records_per_sec'], $report['p50_us'], $report['p99_us'], $report['bytes_per_op']);
+    }
+
+} else {
+    foreach ($reports as $report) {
+        echo json_encode($report), "\n";
+    }
+}
@@ -14,14 +14,39 @@
  */
 
 namespace Titon\Validate {
+    type AsyncBulkConstraintCallback = (function(Vector<mixed>): Awaitable<Vector<bool>>);
+    type AsyncBulkConstraintMap = Map<string, AsyncBulkConstraintCallback>;
+    type AsyncConstraintCallback = (function(mixed): Awaitable<bool>);
+    type AsyncConstraintMap = Map<string, AsyncConstraintCallback>;
+    type BulkConstraintCallback = (function(Vector<mixed>): Vector<bool>);
+    type BuildStats = shape('schema' => string, 'builds' => int, 'time' => float);
+    type BulkConstraintMap = Map<string, BulkConstraintCallback>;
+    type CompiledCondition = shape('name' => string, 'predicate' => ConditionCallback, 'parent' => int, 'keys' => ImmVector<string>);
+    type CompiledConditionList = ImmVector<CompiledCondition>;
+    type CompiledField = shape('field' => string, 'title' => string, 'path' => ?ImmVector<string>, 'condition' => int, 'type' => FieldType, 'rules' => ImmVector<CompiledRule>, 'typed' => ?ImmVector<CompiledRule>);
+    type CompiledFieldList = ImmVector<CompiledField>;
+    type CompiledRule = shape('rule' => string, 'key' => string, 'message' => string, 'options' => ImmVector<mixed>, 'arguments' => array<mixed>, 'arity' => int, 'pure' => bool, 'cost' => float, 'references' => ImmVector<string>, 'pattern' => ?string, 'constraint' => ConstraintCallback, 'bulk' => ?BulkConstraintCallback, 'async' => ?AsyncConstraintCallback, 'asyncBulk' => ?AsyncBulkConstraintCallback, 'template' => MessageTemplate, 'tokens' => ImmMap<string, string>);
+    type Condition = shape('predicate' => ConditionCallback, 'parent' => string, 'keys' => Vector<string>);
+    type ConditionCallback = (function(DataMap): bool);
+    type ConditionMap = Map<string, Condition>;
     type ConstraintCallback = (function(mixed): bool);
     type ConstraintMap = Map<string, ConstraintCallback>;
+    type CrossConstraint = shape('callback' => CrossConstraintCallback, 'references' => int);
+    type CrossConstraintCallback = (function(mixed, RecordView): bool);
+    type CrossConstraintMap = Map<string, CrossConstraint>;
     type DataMap = Map<string, mixed>;
     type ErrorMap = Map<string, string>;
+    type FailureMap = Map<string, int>;
     type FieldMap = Map<string, string>;
+    type InstrumentationSnapshot = shape('sampleRate' => int, 'builds' => Vector<BuildStats>, 'rules' => Vector<RuleStats>);
+    type MemoList = Vector<Map<arraykey, bool>>;
     type MessageMap = Map<string, string>;
     type Rule = shape('rule' => string, 'message' => string, 'options' => OptionList);
     type RuleContainer = Map<string, RuleMap>;
     type RuleMap = Map<string, Rule>;
+    type RuleStats = shape('schema' => string, 'field' => string, 'rule' => string, 'calls' => int, 'failures' => int, 'time' => float, 'messages' => int, 'messageTime' => float);
+    type ScalarConstraintMap = Map<string, Map<FieldType, ConstraintCallback>>;
+    type SchemaCheck = shape('schema' => int, 'field' => int, 'rule' => CompiledRule, 'targets' => Vector<SchemaTarget>);
+    type SchemaTarget = shape('schema' => int, 'field' => int, 'bit' => int);
     type OptionList = Vector<mixed>;
 }